@@ -0,0 +1,114 @@
+#include "Bench.h"
+#include "MemoryTracker.h"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// With PLATFORMGAME_TRACK_HEAP the engine replaces operator new itself and counts for us
+#ifndef PLATFORMGAME_TRACK_HEAP
+
+static std::atomic<int64_t> allocCount{ 0 };
+
+void* operator new(size_t size)
+{
+	allocCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+int64_t BenchAllocCount()
+{
+	return allocCount.load(std::memory_order_relaxed);
+}
+
+#else
+
+int64_t BenchAllocCount()
+{
+	return MemoryTracker::GetHeapAllocTotal();
+}
+
+#endif
+
+static double TimeIterations(const BenchFunction& run, int64_t iterations)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	run((int)iterations);
+	Uint64 end = SDL_GetPerformanceCounter();
+	return (double)(end - start) * 1e9 / (double)SDL_GetPerformanceFrequency();
+}
+
+BenchResult RunBenchmark(const char* name, const BenchFunction& run, double minSampleMs, int samples, int64_t maxIterations)
+{
+	BenchResult result;
+	result.name = name;
+
+	// Warm-up, then grow the iteration count until a sample is long enough to time
+	TimeIterations(run, 1);
+	int64_t iterations = 1;
+	double ns = TimeIterations(run, iterations);
+	while (ns < minSampleMs * 1e6 && iterations < maxIterations)
+	{
+		double scale = ns > 0.0 ? (minSampleMs * 1e6 * 1.2) / ns : 10.0;
+		iterations = std::min(maxIterations, std::max(iterations * 2, (int64_t)(iterations * std::min(scale, 100.0))));
+		ns = TimeIterations(run, iterations);
+	}
+
+	std::vector<double> perOp;
+	int64_t allocs = BenchAllocCount();
+	for (int i = 0; i < samples; ++i)
+		perOp.push_back(TimeIterations(run, iterations) / (double)iterations);
+	allocs = BenchAllocCount() - allocs;
+
+	std::sort(perOp.begin(), perOp.end());
+	result.iterations = iterations;
+	result.nsPerOp = perOp[perOp.size() / 2];
+	result.minNsPerOp = perOp.front();
+	result.allocsPerOp = (double)allocs / (double)(iterations * samples);
+	return result;
+}
+
+std::string BenchResultsToJson(const std::vector<BenchResult>& results)
+{
+	std::string json = "{\n  \"benchmarks\": [\n";
+	char line[512];
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& r = results[i];
+		snprintf(line, sizeof(line),
+			"    {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, \"allocs_per_op\": %.3f}%s\n",
+			r.name.c_str(), (long long)r.iterations, r.nsPerOp, r.minNsPerOp, r.allocsPerOp, i + 1 < results.size() ? "," : "");
+		json += line;
+	}
+	json += "  ]\n}\n";
+	return json;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs 'iterations' operations of the benchmark
+typedef std::function<void(int iterations)> BenchFunction;
+
+struct BenchResult
+{
+	std::string name;
+	int64_t iterations = 0;     // per sample
+	double nsPerOp = 0.0;       // median of the samples
+	double minNsPerOp = 0.0;
+	double allocsPerOp = 0.0;   // operator new calls, over every sample
+};
+
+// C++ heap allocations since the start (operator new is replaced in Bench.cpp)
+int64_t BenchAllocCount();
+
+// Calibrates the iteration count until one sample takes at least minSampleMs,
+// then takes 'samples' samples. maxIterations bounds slow operations (e.g. huge map loads)
+BenchResult RunBenchmark(const char* name, const BenchFunction& run, double minSampleMs, int samples, int64_t maxIterations);
+
+// {"benchmarks":[{"name":...,"iterations":...,"ns_per_op":...,"min_ns_per_op":...,"allocs_per_op":...}]}
+std::string BenchResultsToJson(const std::vector<BenchResult>& results);
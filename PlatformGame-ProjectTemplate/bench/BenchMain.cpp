@@ -0,0 +1,367 @@
+// PlatformBench: micro-benchmarks of the engine hot paths.
+// Run from the game directory (config.xml and Assets/), results are printed as JSON on stdout:
+//   PlatformBench [--filter <text>] [--out <file.json>] [--min-ms <ms per sample>] [--samples <n>]
+
+#include "Bench.h"
+#include "Engine.h"
+#include "Input.h"
+#include "Render.h"
+#include "Map.h"
+#include "Physics.h"
+#include "Animation.h"
+#include "Log.h"
+#include <SDL3/SDL.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+
+#define BENCH_MAP_DIR "Assets/Maps/"
+#define BENCH_SMALL_MAP "MapTemplate.tmx"
+#define BENCH_MEDIUM_MAP "bench_medium.tmx"   // small map repeated 4x4
+#define BENCH_HUGE_MAP "bench_huge.tmx"       // small map repeated 16x16
+#define BENCH_FIXED_DT (1000.0f / 60.0f)
+#define BENCH_OVERLAP_SLOTS 8                 // bodies kept per OverlapAABBs query
+
+// Swallows the log output during the Log benchmark
+class NullBuffer : public std::streambuf
+{
+protected:
+	int overflow(int c) override { return c; }
+	std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Repeats the tile layers of a map (objects are kept once) to get bigger maps with the same tilesets
+static bool WriteRepeatedMap(const char* srcPath, const char* dstPath, int repeatX, int repeatY)
+{
+	pugi::xml_document doc;
+	if (!doc.load_file(srcPath))
+		return false;
+
+	pugi::xml_node map = doc.child("map");
+	int width = map.attribute("width").as_int();
+	int height = map.attribute("height").as_int();
+	map.attribute("width").set_value(width * repeatX);
+	map.attribute("height").set_value(height * repeatY);
+
+	for (pugi::xml_node layer = map.child("layer"); layer; layer = layer.next_sibling("layer"))
+	{
+		std::vector<int> gids;
+		for (pugi::xml_node tile = layer.child("data").child("tile"); tile; tile = tile.next_sibling("tile"))
+			gids.push_back(tile.attribute("gid").as_int());
+		if ((int)gids.size() != width * height)
+			return false;
+
+		layer.attribute("width").set_value(width * repeatX);
+		layer.attribute("height").set_value(height * repeatY);
+		layer.remove_child(layer.child("data"));
+
+		pugi::xml_node data = layer.append_child("data");
+		for (int y = 0; y < height * repeatY; ++y)
+		{
+			for (int x = 0; x < width * repeatX; ++x)
+			{
+				pugi::xml_node tile = data.append_child("tile");
+				int gid = gids[(y % height) * width + (x % width)];
+				if (gid != 0)
+					tile.append_attribute("gid").set_value(gid);
+			}
+		}
+	}
+
+	return doc.save_file(dstPath);
+}
+
+static bool Matches(const char* name, const char* filter)
+{
+	return filter == nullptr || strstr(name, filter) != nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* filter = nullptr;
+	const char* outPath = nullptr;
+	double minSampleMs = 50.0;
+	int samples = 5;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (strcmp(argv[i], "--filter") == 0) filter = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0) outPath = argv[++i];
+		else if (strcmp(argv[i], "--min-ms") == 0) minSampleMs = atof(argv[++i]);
+		else if (strcmp(argv[i], "--samples") == 0) samples = atoi(argv[++i]);
+	}
+
+	// RunBenchmark takes the median of the samples, it needs at least one
+	if (samples < 1)
+	{
+		LOG("PlatformBench: --samples must be at least 1");
+		return EXIT_FAILURE;
+	}
+
+	// Headless: no window on screen, no sound card needed
+	SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+	SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+
+	Engine& engine = Engine::GetInstance();
+	engine.SetFixedDt(BENCH_FIXED_DT);
+	if (!engine.Awake() || !engine.Start())
+	{
+		LOG("PlatformBench: engine start failed");
+		return EXIT_FAILURE;
+	}
+
+	// Without them the Map::Load samples would time a failed load
+	if (!WriteRepeatedMap(BENCH_MAP_DIR BENCH_SMALL_MAP, BENCH_MAP_DIR BENCH_MEDIUM_MAP, 4, 4) ||
+		!WriteRepeatedMap(BENCH_MAP_DIR BENCH_SMALL_MAP, BENCH_MAP_DIR BENCH_HUGE_MAP, 16, 16))
+	{
+		LOG("PlatformBench: cannot write the generated maps to %s", BENCH_MAP_DIR);
+		engine.CleanUp();
+		remove(BENCH_MAP_DIR BENCH_MEDIUM_MAP);
+		remove(BENCH_MAP_DIR BENCH_HUGE_MAP);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<BenchResult> results;
+	auto run = [&](const char* name, const BenchFunction& fn, int64_t maxIterations = 100000000)
+	{
+		if (!Matches(name, filter))
+			return;
+		results.push_back(RunBenchmark(name, fn, minSampleMs, samples, maxIterations));
+		LOG("PlatformBench: %s %.1f ns/op", name, results.back().nsPerOp);
+	};
+
+	// Log ---------------------------------------------------------------
+	run("Log", [](int n)
+	{
+		NullBuffer null;
+		std::streambuf* old = std::cerr.rdbuf(&null);
+		for (int i = 0; i < n; ++i)
+			LOG("bench message %d: %s %.2f", i, "text", 1.5f);
+		std::cerr.rdbuf(old);
+	});
+
+	// Input -------------------------------------------------------------
+	run("Input::PreUpdate/idle", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+			engine.input->PreUpdate();
+	});
+
+	run("Input::PreUpdate/8_key_events", [&](int n)
+	{
+		const SDL_Scancode keys[] = { SDL_SCANCODE_A, SDL_SCANCODE_D, SDL_SCANCODE_SPACE, SDL_SCANCODE_LSHIFT };
+		for (int i = 0; i < n; ++i)
+		{
+			for (int down = 1; down >= 0; --down)
+			{
+				for (SDL_Scancode key : keys)
+				{
+					SDL_Event event;
+					SDL_zero(event);
+					event.type = down ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+					event.key.scancode = key;
+					event.key.down = down != 0;
+					event.key.timestamp = SDL_GetTicksNS();
+					SDL_PushEvent(&event);
+				}
+			}
+			engine.input->PreUpdate();
+		}
+	});
+
+	// Animation ---------------------------------------------------------
+	AnimationSet anims;
+	anims.LoadFromTSX("Assets/Textures/Player2_Spritesheet.tsx", { {0, "idle"}, {11, "move"}, {22, "jump"} });
+	anims.SetCurrent("move");
+	run("AnimationSet::Update", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+			anims.Update(BENCH_FIXED_DT / 1000.0f);
+	});
+
+	// Physics -----------------------------------------------------------
+	const int bodyCounts[] = { 0, 100, 1000 };
+	for (int count : bodyCounts)
+	{
+		std::vector<PhysBody*> bodies;
+		for (int i = 0; i < count; ++i)
+			bodies.push_back(engine.physics->CreateCircle(64 + (i % 50) * 24, 64 + (i / 50) * 24, 8, bodyType::DYNAMIC));
+
+		std::string name = "Physics::PreUpdate/" + std::to_string(count) + "_bodies";
+		run(name.c_str(), [&](int n)
+		{
+			for (int i = 0; i < n; ++i)
+				engine.physics->PreUpdate();
+		});
+
+		for (PhysBody* body : bodies)
+			engine.physics->DeletePhysBody(body);
+	}
+
+	// Map queries and drawing (the map loaded by Scene::Start) ----------
+	engine.map->CleanUp();
+	engine.map->Load(BENCH_MAP_DIR, BENCH_SMALL_MAP);
+
+	run("Map::GetTilesetFromTileId", [&](int n)
+	{
+		volatile TileSet* sink = nullptr;
+		for (int i = 0; i < n; ++i)
+			sink = engine.map->GetTilesetFromTileId(1 + (i % 1304));
+		(void)sink;
+	});
+
+	// Batched queries over the map colliders: ground probes down the whole map, shape casts
+	// (circles and boxes) along the same lines and boxes spread over the map
+	Vector2D mapSize = engine.map->GetMapSizeInPixels();
+	bool queriesOk = true;
+	const int queryCounts[] = { 64, 1024 };
+	for (int count : queryCounts)
+	{
+		std::vector<RayQuery> rays(count);
+		std::vector<ShapeCastQuery> casts(count);
+		std::vector<AABBQuery> boxes(count);
+		for (int i = 0; i < count; ++i)
+		{
+			float x = mapSize.getX() * (i + 0.5f) / count;
+			rays[i] = { x, 0.0f, x, mapSize.getY() };
+			casts[i] = { x, 0.0f, 0.0f, mapSize.getY(), (i & 1) ? 8.0f : 0.0f, 12.0f, 16.0f };
+			boxes[i] = { x - 48.0f, mapSize.getY() * (i % 8) / 8.0f, 96.0f, 96.0f };
+		}
+
+		std::vector<QueryHit> hits(count);
+		std::vector<QueryHit> platformHits(count);
+		std::vector<PhysBody*> found((size_t)count * BENCH_OVERLAP_SLOTS);
+		std::vector<int> foundCounts(count);
+
+		std::string suffix = "/" + std::to_string(count);
+		std::string name = "Physics::CastRays" + suffix;
+		run(name.c_str(), [&](int n)
+		{
+			for (int i = 0; i < n; ++i)
+				engine.physics->CastRays(rays.data(), hits.data(), 0, count, COLLIDER_MASK_ALL);
+		});
+
+		name = "Physics::CastShapes" + suffix;
+		run(name.c_str(), [&](int n)
+		{
+			for (int i = 0; i < n; ++i)
+				engine.physics->CastShapes(casts.data(), hits.data(), 0, count, COLLIDER_MASK_ALL);
+		});
+
+		name = "Physics::OverlapAABBs" + suffix;
+		run(name.c_str(), [&](int n)
+		{
+			for (int i = 0; i < n; ++i)
+				engine.physics->OverlapAABBs(boxes.data(), found.data(), BENCH_OVERLAP_SLOTS, foundCounts.data(), 0, count, COLLIDER_MASK_ALL);
+		});
+
+		// Checks, also when the runs above were filtered out:
+		// - closest hit: a narrower mask never finds a closer hit, and only bodies of its type
+		// - overlaps: each body once per query, however many of its shapes overlap
+		engine.physics->CastRays(rays.data(), hits.data(), 0, count, COLLIDER_MASK_ALL);
+		engine.physics->CastRays(rays.data(), platformHits.data(), 0, count, COLLIDER_MASK(ColliderType::PLATFORM));
+		engine.physics->OverlapAABBs(boxes.data(), found.data(), BENCH_OVERLAP_SLOTS, foundCounts.data(), 0, count, COLLIDER_MASK_ALL);
+
+		int hitCount = 0;
+		int overlapCount = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			const QueryHit& platform = platformHits[i];
+			if (platform.hit && (!hits[i].hit || platform.fraction < hits[i].fraction || platform.body->ctype != ColliderType::PLATFORM))
+				queriesOk = false;
+			hitCount += hits[i].hit ? 1 : 0;
+
+			PhysBody** bodies = found.data() + (size_t)i * BENCH_OVERLAP_SLOTS;
+			for (int a = 0; a < foundCounts[i]; ++a)
+			{
+				for (int b = a + 1; b < foundCounts[i]; ++b)
+				{
+					if (bodies[a] == bodies[b])
+						queriesOk = false;
+				}
+			}
+			overlapCount += foundCounts[i];
+		}
+		LOG("PlatformBench: %d queries, %d rays hit, %d bodies overlapped", count, hitCount, overlapCount);
+	}
+
+	if (!queriesOk)
+		LOG("PlatformBench: batched query check FAILED");
+
+	// The renderer batches the draw calls: flush each frame so the queue doesn't grow
+	run("Map::Update/small+flush", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			engine.map->Update(BENCH_FIXED_DT);
+			SDL_FlushRenderer(engine.render->renderer);
+		}
+	});
+
+	// Whole frames without frame cap: allocs_per_op should stay at 0, transient data goes to the frame arena
+	engine.SetTargetFrameRate(0);
+	run("Engine::Update/frame", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+			engine.Update();
+	}, 100000);
+
+	// With the tilesets and sprites in atlases most draws of a frame share a texture
+	RenderCounters frameCounters = engine.render->GetStats().Total();
+	LOG("PlatformBench: last frame %d sprites, %d texture switches", frameCounters.sprites, frameCounters.textureSwitches);
+
+	// Map loading. Each CleanUp releases the previous level, so the level arena should stop growing
+	// after the first load of each size (see the log line below)
+	run("Map::Load/small", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			engine.map->CleanUp();
+			engine.map->Load(BENCH_MAP_DIR, BENCH_SMALL_MAP);
+		}
+	}, 200);
+
+	run("Map::Load/medium", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			engine.map->CleanUp();
+			engine.map->Load(BENCH_MAP_DIR, BENCH_MEDIUM_MAP);
+		}
+	}, 20);
+
+	run("Map::Load/huge", [&](int n)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			engine.map->CleanUp();
+			engine.map->Load(BENCH_MAP_DIR, BENCH_HUGE_MAP);
+		}
+	}, 2);
+
+	LevelArena& levelArena = engine.GetLevelArena();
+	LOG("PlatformBench: level arena %zu bytes reserved, %zu bytes high water", levelArena.GetReserved(), levelArena.GetHighWater());
+
+	engine.CleanUp();
+	remove(BENCH_MAP_DIR BENCH_MEDIUM_MAP);
+	remove(BENCH_MAP_DIR BENCH_HUGE_MAP);
+
+	std::string json = BenchResultsToJson(results);
+	if (outPath != nullptr)
+	{
+		FILE* out = fopen(outPath, "w");
+		if (out == nullptr)
+		{
+			LOG("PlatformBench: cannot write %s", outPath);
+			return EXIT_FAILURE;
+		}
+		fputs(json.c_str(), out);
+		fclose(out);
+	}
+	else
+	{
+		fputs(json.c_str(), stdout);
+	}
+
+	return queriesOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,230 @@
+// PlatformRegression: frame-time regression check on a headless run of the game.
+// Loads a level, optionally replays a recorded input file (--record in the game), steps N frames
+// at fixed dt without frame cap and compares the per-module percentiles with a baseline.
+// Run from the game directory (config.xml and Assets/):
+//
+//   PlatformRegression [--replay <input file>] [--level n] [--frames n] [--warmup n]
+//                      [--baseline regression/baseline.json] [--threshold 1.20] [--slack-ms 0.10]
+//                      [--out results.json] [--update-baseline]
+//
+// A percentile fails when it is over baseline * threshold + slack. The baseline must be made on
+// the machine that runs the check, with --update-baseline.
+
+#include "Engine.h"
+#include "Scene.h"
+#include "Stats.h"
+#include "Log.h"
+#include <SDL3/SDL.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define REGRESSION_FIXED_DT (1000.0f / 60.0f)
+
+struct FrameStats
+{
+	std::string name;
+	float p50 = 0.0f;
+	float p95 = 0.0f;
+	float p99 = 0.0f;
+	float max = 0.0f;
+};
+
+static FrameStats ComputeStats(const std::string& name, std::vector<float> values)
+{
+	FrameStats stats;
+	stats.name = name;
+	int count = (int)values.size();
+	stats.p50 = PercentileOf(values.data(), count, 50.0f);
+	stats.p95 = PercentileOf(values.data(), count, 95.0f);
+	stats.p99 = PercentileOf(values.data(), count, 99.0f);
+	stats.max = PercentileOf(values.data(), count, 100.0f);
+	return stats;
+}
+
+// One module per line, so the baseline can be read back with sscanf
+static bool WriteResults(const char* path, const std::vector<FrameStats>& results, int frames, int level)
+{
+	FILE* out = path != nullptr ? fopen(path, "w") : stdout;
+	if (out == nullptr)
+	{
+		LOG("PlatformRegression: cannot write %s", path);
+		return false;
+	}
+
+	fprintf(out, "{\n  \"frames\": %d,\n  \"level\": %d,\n  \"modules\": {\n", frames, level);
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const FrameStats& s = results[i];
+		fprintf(out, "    \"%s\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+			s.name.c_str(), s.p50, s.p95, s.p99, s.max, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(out, "  }\n}\n");
+
+	if (out != stdout)
+		fclose(out);
+	return true;
+}
+
+static bool ReadBaseline(const char* path, std::vector<FrameStats>& baseline)
+{
+	FILE* in = fopen(path, "r");
+	if (in == nullptr)
+		return false;
+
+	char line[512];
+	while (fgets(line, sizeof(line), in))
+	{
+		char name[64];
+		FrameStats s;
+		if (sscanf(line, " \"%63[^\"]\": {\"p50\": %f, \"p95\": %f, \"p99\": %f, \"max\": %f",
+			name, &s.p50, &s.p95, &s.p99, &s.max) == 5)
+		{
+			s.name = name;
+			baseline.push_back(s);
+		}
+	}
+
+	fclose(in);
+	return !baseline.empty();
+}
+
+static bool Check(const char* name, const char* percentile, float current, float base, float threshold, float slackMs)
+{
+	float limit = base * threshold + slackMs;
+	bool ok = current <= limit;
+	printf("  %-16s %-4s %9.4f ms  baseline %9.4f  limit %9.4f  %s\n", name, percentile, current, base, limit, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* replayPath = nullptr;
+	const char* baselinePath = "regression/baseline.json";
+	const char* outPath = nullptr;
+	int level = 1;
+	int frames = 600;
+	int warmup = 60;
+	float threshold = 1.20f;
+	float slackMs = 0.10f;
+	bool updateBaseline = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--update-baseline") == 0) { updateBaseline = true; continue; }
+		if (i + 1 >= argc) break;
+
+		if (strcmp(argv[i], "--replay") == 0) replayPath = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0) baselinePath = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0) outPath = argv[++i];
+		else if (strcmp(argv[i], "--level") == 0) level = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--frames") == 0) frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--warmup") == 0) warmup = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threshold") == 0) threshold = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--slack-ms") == 0) slackMs = (float)atof(argv[++i]);
+	}
+
+	// Headless: no window on screen, no sound card needed
+	SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+	SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+
+	Engine& engine = Engine::GetInstance();
+	if (replayPath != nullptr)
+	{
+		// The recording brings its own config, seed, level and dt
+		char* replayArgs[] = { argv[0], (char*)"--replay", (char*)replayPath };
+		engine.ParseCommandLine(3, replayArgs);
+	}
+	else
+	{
+		engine.scene->startLevel = level;
+		engine.SetFixedDt(REGRESSION_FIXED_DT);
+	}
+
+	if (!engine.Awake() || !engine.Start())
+	{
+		LOG("PlatformRegression: engine start failed");
+		return EXIT_FAILURE;
+	}
+	engine.SetTargetFrameRate(0);
+
+	// Scene::LoadLevel falls back to another level when it can't load the one asked for:
+	// that run must not be measured against (or saved as) the baseline of the requested level
+	level = engine.scene->startLevel;
+	if (engine.scene->GetCurrentLevel() != level)
+	{
+		LOG("PlatformRegression: level %d could not be loaded", level);
+		return EXIT_FAILURE;
+	}
+
+	// Let the loads and the first allocations settle before measuring
+	bool running = true;
+	for (int i = 0; i < warmup && running; ++i)
+		running = engine.Update();
+
+	engine.SetModuleProfiling(true, frames);
+	int ran = 0;
+	while (running && ran < frames)
+	{
+		running = engine.Update();
+		++ran;
+	}
+
+	std::vector<FrameStats> results;
+	for (const ModuleTimings& module : engine.GetModuleTimings())
+		results.push_back(ComputeStats(module.name, module.frameMs));
+	results.push_back(ComputeStats("frame", engine.GetFrameTimings()));
+
+	engine.SetModuleProfiling(false);
+	engine.CleanUp();
+
+	if (ran < frames)
+		LOG("PlatformRegression: the run ended after %d of %d frames", ran, frames);
+
+	if (outPath != nullptr && !WriteResults(outPath, results, ran, level))
+		return EXIT_FAILURE;
+
+	if (updateBaseline)
+	{
+		if (!WriteResults(baselinePath, results, ran, level))
+			return EXIT_FAILURE;
+		printf("PlatformRegression: baseline written to %s (%d frames)\n", baselinePath, ran);
+		return EXIT_SUCCESS;
+	}
+
+	std::vector<FrameStats> baseline;
+	if (!ReadBaseline(baselinePath, baseline))
+	{
+		printf("PlatformRegression: no baseline at %s, create it with --update-baseline\n", baselinePath);
+		return EXIT_FAILURE;
+	}
+
+	// max is reported but not checked: a single hitch would make the check flaky
+	bool ok = true;
+	printf("PlatformRegression: %d frames, threshold x%.2f + %.2f ms\n", ran, threshold, slackMs);
+	for (const FrameStats& base : baseline)
+	{
+		const FrameStats* current = nullptr;
+		for (const FrameStats& r : results)
+		{
+			if (r.name == base.name)
+				current = &r;
+		}
+
+		if (current == nullptr)
+		{
+			printf("  %-16s missing from this run\n", base.name.c_str());
+			continue;
+		}
+
+		ok &= Check(base.name.c_str(), "p50", current->p50, base.p50, threshold, slackMs);
+		ok &= Check(base.name.c_str(), "p95", current->p95, base.p95, threshold, slackMs);
+		ok &= Check(base.name.c_str(), "p99", current->p99, base.p99, threshold, slackMs);
+		printf("  %-16s max  %9.4f ms  baseline %9.4f\n", base.name.c_str(), current->max, base.max);
+	}
+
+	printf("PlatformRegression: %s\n", ok ? "PASSED" : "FAILED");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,34 +1,25 @@
 #include "Audio.h"
 #include "Log.h"
+#include "MemoryTracker.h"
 
 Audio::Audio() {
     name = "audio";
+    memTag = MemTag::AUDIO;
 }
 
 Audio::~Audio() {
     // Make sure everything is freed in CleanUp
 }
 
-bool Audio::LoadWavFile(const char* path, SoundData& out) {
-    // SDL_LoadWAV fills spec + allocates buf; free with SDL_free() later.
-    if (!SDL_LoadWAV(path, &out.spec, &out.buf, &out.len)) {
-        SDL_Log("SDL_LoadWAV failed for %s: %s", path, SDL_GetError());
-        return false;
-    }
-    return true;
-}
-
-void Audio::FreeSound(SoundData& s) {
-    if (s.buf) {
-        SDL_free(s.buf);
-        s.buf = nullptr;
-        s.len = 0;
-        s.spec = SDL_AudioSpec{};
+int Audio::FindFx(const char* path) const {
+    for (size_t i = 0; i < sfx_.size(); ++i) {
+        if (sfx_[i].path == path) return static_cast<int>(i + 1);
     }
+    return 0;
 }
 
 bool Audio::EnsureDeviceOpen() {
-    if (device_ != 0) return true;
+    if (device_ != 0 || offline_) return true;
 
     // Ask for a reasonable default device format (float32, stereo, 48k).
     SDL_AudioSpec want{};
@@ -36,6 +27,13 @@ bool Audio::EnsureDeviceOpen() {
     want.channels = 2;
     want.freq = 48000;
 
+    // Smaller device buffers lower the latency, at the risk of underruns on slow machines
+    if (requested_frames_ > 0) {
+        char frames[16];
+        SDL_snprintf(frames, sizeof(frames), "%d", requested_frames_);
+        SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, frames);
+    }
+
     device_ = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &want);
     if (device_ == 0) {
         LOG("Audio: SDL_OpenAudioDevice failed: %s", SDL_GetError());
@@ -43,78 +41,109 @@ bool Audio::EnsureDeviceOpen() {
     }
 
     // Query actual device format (may differ from 'want')
-    if (!SDL_GetAudioDeviceFormat(device_, &device_spec_, nullptr)) {
+    if (!SDL_GetAudioDeviceFormat(device_, &device_spec_, &device_frames_)) {
         LOG("Audio: SDL_GetAudioDeviceFormat failed: %s", SDL_GetError());
         SDL_CloseAudioDevice(device_);
         device_ = 0;
         return false;
     }
 
+    LOG("Audio: device %d Hz, %d channels, %d sample frames (requested %d)",
+        device_spec_.freq, device_spec_.channels, device_frames_, requested_frames_);
+
     // Start audio
     SDL_ResumeAudioDevice(device_);
 
     return true;
 }
 
+bool Audio::StartOffline(int rate, const char* wavPath, bool keepInMemory) {
+    // Same layout as the default device, at a fixed rate
+    device_spec_.format = SDL_AUDIO_F32;
+    device_spec_.channels = 2;
+    device_spec_.freq = rate > 0 ? rate : DEFAULT_OFFLINE_RATE;
+    device_frames_ = 0;
+    offline_frame_remainder_ = 0.0;
+    offline_ = true;
+
+    LOG("Audio: offline backend at %d Hz, %d frames per tick (0 = from dt)", device_spec_.freq, offline_tick_frames_);
+
+    return offline_output_.Open(device_spec_, wavPath, keepInMemory);
+}
+
 bool Audio::EnsureStreams() {
+    // Called every tick by the offline backend: the command queues are small, post the gains once
+    if (streams_ready_) return true;
     if (!EnsureDeviceOpen()) return false;
 
-    if (!music_stream_) {
-        music_stream_ = SDL_CreateAudioStream(nullptr, &device_spec_);
-        if (!music_stream_) {
-            LOG("Audio: SDL_CreateAudioStream (music) failed: %s", SDL_GetError());
-            return false;
-        }
-        if (!SDL_BindAudioStream(device_, music_stream_)) {
-            LOG("Audio: SDL_BindAudioStream (music) failed: %s", SDL_GetError());
-            SDL_DestroyAudioStream(music_stream_);
-            music_stream_ = nullptr;
-            return false;
-        }
+    if (!music_.Init(device_, device_spec_)) {
+        return false;
     }
+    music_.SetVolume(music_volume_);
 
-    if (!sfx_stream_) {
-        sfx_stream_ = SDL_CreateAudioStream(nullptr, &device_spec_);
-        if (!sfx_stream_) {
-            LOG("Audio: SDL_CreateAudioStream (sfx) failed: %s", SDL_GetError());
-            return false;
-        }
-        if (!SDL_BindAudioStream(device_, sfx_stream_)) {
-            LOG("Audio: SDL_BindAudioStream (sfx) failed: %s", SDL_GetError());
-            SDL_DestroyAudioStream(sfx_stream_);
-            sfx_stream_ = nullptr;
-            return false;
-        }
+    if (!mixer_.Init(device_, device_spec_)) {
+        return false;
+    }
+    mixer_.SetGain(fx_volume_);
+
+    // Effects are converted by the loader to the mixer format
+    SDL_AudioSpec mixSpec{};
+    mixSpec.format = SDL_AUDIO_F32;
+    mixSpec.channels = device_spec_.channels;
+    mixSpec.freq = device_spec_.freq;
+    if (!loader_.Start(mixSpec)) {
+        return false;
     }
 
+    streams_ready_ = true;
     return true;
 }
 
 
 bool Audio::Awake() {
     LOG("Audio: initializing SDL3 audio");
+    requested_frames_ = configParameters.child("bufferFrames").attribute("value").as_int(0);
+
+    pugi::xml_node offline = configParameters.child("offline");
+    const bool wantOffline = offline.attribute("value").as_bool(false);
+    offline_tick_frames_ = offline.attribute("tickFrames").as_int(0);
+
+    // The offline backend never opens a device, it also runs where there is no sound card
+    if (wantOffline) SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+
     if (SDL_InitSubSystem(SDL_INIT_AUDIO) != true /* SDL3 returns bool */) {
         LOG("SDL_INIT_AUDIO failed: %s", SDL_GetError());
         active = false;
         return true; // don't hard-fail the app
     }
 
-    if (!EnsureDeviceOpen()) {
-        active = false;
+    if (wantOffline) {
+        if (!StartOffline(offline.attribute("rate").as_int(DEFAULT_OFFLINE_RATE),
+            offline.attribute("wav").as_string(), offline.attribute("memory").as_bool(false))) {
+            active = false;
+        }
         return true;
     }
 
+    // No playback device: keep mixing offline with no output so the game behaves the same
+    if (!EnsureDeviceOpen()) {
+        LOG("Audio: no playback device, falling back to the offline backend");
+        StartOffline(DEFAULT_OFFLINE_RATE, nullptr, false);
+    }
+
     return true;
 }
 
 bool Audio::CleanUp() {
     // If audio is inactive or already quit elsewhere, don't touch SDL objects.
+    offline_output_.Close();
+
     if (!active || !SDL_WasInit(SDL_INIT_AUDIO)) {
-        music_stream_ = nullptr;
-        sfx_stream_ = nullptr;
         device_ = 0;
+        offline_ = false;
+        streams_ready_ = false;
         sfx_.clear();
-        FreeSound(music_data_);
+        FreeArenas();
         return true;
     }
 
@@ -123,19 +152,16 @@ bool Audio::CleanUp() {
     // Optional: stop pulling data while we tear down.
     if (device_ != 0) SDL_PauseAudioDevice(device_);
 
-    // Destroy streams (auto-unbinds if bound).
-    if (music_stream_) {
-        SDL_DestroyAudioStream(music_stream_);
-        music_stream_ = nullptr;
-    }
-    FreeSound(music_data_);
+    // Stop the loader first so nothing new is handed to the streams
+    loader_.Stop();
 
-    if (sfx_stream_) {
-        SDL_DestroyAudioStream(sfx_stream_);
-        sfx_stream_ = nullptr;
-    }
-    for (auto& s : sfx_) FreeSound(s);
+    // Destroy streams (auto-unbinds if bound).
+    music_.Shutdown();
+    mixer_.Shutdown();
+    streams_ready_ = false;
     sfx_.clear();
+    musicPath_.clear();
+    FreeArenas();
 
     // Close device after streams are gone.
     if (device_ != 0) {
@@ -143,116 +169,183 @@ bool Audio::CleanUp() {
         device_ = 0;
     }
 
+    offline_ = false;
+
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
     active = false;
     return true;
 }
 
-bool Audio::PlayMusic(const char* path, float fadeTime) {
-    if (!active) return false;
-    if (!EnsureStreams()) return false;
+bool Audio::PreUpdate() {
+    if (!active) return true;
 
-    // Stop any existing music: clear stream + free buffer
-    if (music_stream_) {
-        SDL_ClearAudioStream(music_stream_);
+    // Effects finished by the loader: append them all to a new arena in one go
+    LoadedFx loaded[AUDIO_LOADER_QUEUE];
+    int loadedCount = 0;
+    size_t added = 0;
+    while (loadedCount < AUDIO_LOADER_QUEUE && loader_.PollFx(loaded[loadedCount])) {
+        added += (size_t)loaded[loadedCount].frames * device_spec_.channels;
+        ++loadedCount;
     }
-    FreeSound(music_data_);
 
-    // Load WAV into memory
-    if (!LoadWavFile(path, music_data_)) {
-        LOG("Audio: cannot load music %s: %s", path, SDL_GetError());
-        return false;
+    if (added > 0) {
+        float* arena = (float*)SDL_malloc(sizeof(float) * (fxArenaSize_ + added));
+        if (arena != nullptr) {
+            // Old samples keep their offsets, voices playing them are not affected
+            if (fxArenaSize_ > 0) SDL_memcpy(arena, fxArena_, sizeof(float) * fxArenaSize_);
+            for (int i = 0; i < loadedCount; ++i) {
+                if (loaded[i].samples == nullptr) continue;
+                const size_t count = (size_t)loaded[i].frames * device_spec_.channels;
+                SDL_memcpy(arena + fxArenaSize_, loaded[i].samples, sizeof(float) * count);
+
+                FxData& fx = sfx_[static_cast<size_t>(loaded[i].id - 1)];
+                fx.offset = fxArenaSize_;
+                fx.frames = loaded[i].frames;
+                fxArenaSize_ += count;
+            }
+            mixer_.SetArena(arena);
+            fxArena_ = arena; // the previous one comes back retired from the mixer
+            MemoryTracker::Set(MemTag::AUDIO, (int64_t)(sizeof(float) * fxArenaSize_), (int64_t)sfx_.size());
+        }
     }
-
-    // Set input format of the stream to match this file
-    if (!SDL_SetAudioStreamFormat(music_stream_, &music_data_.spec, &device_spec_)) {
-        LOG("Audio: SDL_SetAudioStreamFormat(music) failed: %s", SDL_GetError());
-        return false;
+    for (int i = 0; i < loadedCount; ++i) SDL_free(loaded[i].samples);
+
+    // Music opened by the loader, dropped if another track was requested meanwhile
+    LoadedMusic music;
+    while (loader_.PollMusic(music)) {
+        if (music.decoder != nullptr && musicPath_ == music.path) {
+            music_.Play(music.decoder, music.fadeTime);
+            LOG("Audio: streaming music %s", music.path);
+        }
+        else {
+            if (music.decoder == nullptr) LOG("Audio: cannot play music %s", music.path);
+            delete music.decoder;
+        }
     }
 
-    // Apply volume gain to music stream
-    SDL_SetAudioStreamGain(music_stream_, music_volume_);
+    // Buffers the audio thread is done with
+    while (float* old = mixer_.CollectRetired()) SDL_free(old);
+    music_.CollectRetired();
 
-    // Queue once (simple play). For looping, requeue when drained (TODO).
-    if (!SDL_PutAudioStreamData(music_stream_, music_data_.buf, music_data_.len)) {
-        LOG("Audio: SDL_PutAudioStreamData(music) failed: %s", SDL_GetError());
-        return false;
+    return true;
+}
+
+bool Audio::Update(float dt) {
+    if (!active || !offline_) return true;
+
+    // Fixed frames per tick for deterministic output, or the frames of dt (ms) carrying the remainder
+    int frames = offline_tick_frames_;
+    if (frames <= 0) {
+        offline_frame_remainder_ += (double)dt * device_spec_.freq / 1000.0;
+        frames = (int)offline_frame_remainder_;
+        offline_frame_remainder_ -= frames;
     }
 
-    LOG("Audio: playing music %s at volume %.2f", path, music_volume_);
+    RenderOffline(frames);
     return true;
 }
 
-int Audio::LoadFx(const char* path) {
-    if (!active) return 0;
+int Audio::RenderOffline(int frames) {
+    if (!active || !offline_ || frames <= 0) return 0;
     if (!EnsureStreams()) return 0;
 
-    SoundData s{};
-    if (!LoadWavFile(path, s)) {
-        LOG("Audio: cannot load fx %s: %s", path, SDL_GetError());
-        return 0;
+    const int channels = device_spec_.channels;
+    int done = 0;
+    while (done < frames) {
+        const int chunk = (frames - done) < MIXER_CHUNK_FRAMES ? (frames - done) : MIXER_CHUNK_FRAMES;
+        const int count = chunk * channels;
+
+        // Both streams run their callbacks here, short reads are silence
+        int got = mixer_.Render(offline_mix_, chunk);
+        SDL_memset(offline_mix_ + got * channels, 0, sizeof(float) * (count - got * channels));
+
+        got = music_.Render(offline_music_, chunk);
+        for (int i = 0; i < got * channels; ++i) {
+            float s = offline_mix_[i] + offline_music_[i];
+            offline_mix_[i] = s > 1.0f ? 1.0f : (s < -1.0f ? -1.0f : s);
+        }
+
+        offline_output_.Write(offline_mix_, chunk);
+        done += chunk;
     }
 
-    sfx_.push_back(s);
-    return static_cast<int>(sfx_.size()); // 1-based outward index
+    return done;
 }
 
-bool Audio::PlayFx(int id, int repeat) {
+void Audio::FreeArenas() {
+    while (float* old = mixer_.CollectRetired()) SDL_free(old);
+    SDL_free(fxArena_);
+    fxArena_ = nullptr;
+    fxArenaSize_ = 0;
+    MemoryTracker::Set(MemTag::AUDIO, 0, 0);
+}
+
+bool Audio::PlayMusic(const char* path, float fadeTime) {
     if (!active) return false;
-    if (id <= 0 || id > static_cast<int>(sfx_.size())) return false;
     if (!EnsureStreams()) return false;
 
-    const SoundData& s = sfx_[static_cast<size_t>(id - 1)];
+    // Already playing or loading
+    if (musicPath_ == path) return true;
+    musicPath_ = path;
 
-    // Make sure the SFX stream input format matches this sound
-    if (!SDL_SetAudioStreamFormat(sfx_stream_, &s.spec, &device_spec_)) {
-        LOG("Audio: SDL_SetAudioStreamFormat(sfx) failed: %s", SDL_GetError());
-        return false;
-    }
+    // Opened on the loader thread, then chunks are decoded on demand by the stream callback
+    loader_.RequestMusic(path, fadeTime);
 
-    // Apply volume gain to sfx stream
-    SDL_SetAudioStreamGain(sfx_stream_, fx_volume_);
+    LOG("Audio: requested music %s at volume %.2f", path, music_volume_);
+    return true;
+}
 
-    // Queue sound 'repeat+1' times
-    for (int i = 0; i <= repeat; ++i) {
-        if (!SDL_PutAudioStreamData(sfx_stream_, s.buf, s.len)) {
-            LOG("Audio: SDL_PutAudioStreamData(sfx) failed: %s", SDL_GetError());
-            return false;
-        }
-    }
+int Audio::LoadFx(const char* path) {
+    if (!active) return 0;
+    if (!EnsureStreams()) return 0;
 
-    return true;
+    // Same file loaded twice shares the samples
+    int existing = FindFx(path);
+    if (existing != 0) return existing;
+
+    // Reserve the id now, the samples arrive in PreUpdate once the loader is done
+    FxData fx{};
+    fx.path = path;
+    sfx_.push_back(fx);
+    int id = static_cast<int>(sfx_.size()); // 1-based outward index
+
+    loader_.RequestFx(id, path);
+    return id;
+}
+
+bool Audio::PlayFx(int id, int repeat) {
+    return PlayFx(id, 1.0f, 0.0f, 0, repeat);
 }
 
 bool Audio::PlayFx(int id, float volume, int repeat) {
+    return PlayFx(id, volume, 0.0f, 0, repeat);
+}
+
+bool Audio::PlayFx(int id, float volume, float pan, int priority, int repeat) {
     if (!active) return false;
     if (id <= 0 || id > static_cast<int>(sfx_.size())) return false;
-    if (!EnsureStreams()) return false;
 
     // Clamp volume between 0.0 and 1.0
     if (volume < 0.0f) volume = 0.0f;
     if (volume > 1.0f) volume = 1.0f;
 
-    const SoundData& s = sfx_[static_cast<size_t>(id - 1)];
-
-    // Make sure the SFX stream input format matches this sound
-    if (!SDL_SetAudioStreamFormat(sfx_stream_, &s.spec, &device_spec_)) {
-        LOG("Audio: SDL_SetAudioStreamFormat(sfx) failed: %s", SDL_GetError());
-        return false;
-    }
+    // Per voice gain, the FX volume is the gain of the whole mix.
+    // Only posts a command: no lock and no allocation. Effects still loading are skipped.
+    const FxData& fx = sfx_[static_cast<size_t>(id - 1)];
+    return mixer_.Play(id, fx.offset, fx.frames, volume, pan, priority, repeat);
+}
 
-    // Apply CUSTOM volume gain to sfx stream (override default fx_volume_)
-    SDL_SetAudioStreamGain(sfx_stream_, volume);
+void Audio::StopMusic(float fadeTime) {
+    musicPath_.clear();
+    music_.Stop(fadeTime);
+}
 
-    // Queue sound 'repeat+1' times
-    for (int i = 0; i <= repeat; ++i) {
-        if (!SDL_PutAudioStreamData(sfx_stream_, s.buf, s.len)) {
-            LOG("Audio: SDL_PutAudioStreamData(sfx) failed: %s", SDL_GetError());
-            return false;
-        }
-    }
+void Audio::SetMusicLoopPoints(int startFrame, int endFrame) {
+    music_.SetLoopPoints(startFrame, endFrame);
+}
 
-    return true;
+void Audio::SetFxLimit(int fx, int maxVoices) {
+    mixer_.SetFxLimit(fx, maxVoices);
 }
 
 void Audio::SetMusicVolume(float volume) {
@@ -262,10 +355,8 @@ void Audio::SetMusicVolume(float volume) {
 
     music_volume_ = volume;
 
-    // Apply to stream if it exists
-    if (music_stream_) {
-        SDL_SetAudioStreamGain(music_stream_, music_volume_);
-    }
+    // Gain of the music stream
+    music_.SetVolume(music_volume_);
 
     LOG("Audio: Music volume set to %.2f", music_volume_);
 }
@@ -277,17 +368,30 @@ void Audio::SetFxVolume(float volume) {
 
     fx_volume_ = volume;
 
-    // Apply to stream if it exists
-    if (sfx_stream_) {
-        SDL_SetAudioStreamGain(sfx_stream_, fx_volume_);
-    }
+    // Gain of the mixed stream
+    mixer_.SetGain(fx_volume_);
 
     LOG("Audio: FX volume set to %.2f", fx_volume_);
 }
 
 void Audio::StopAllFx() {
-    if (sfx_stream_) {
-        SDL_ClearAudioStream(sfx_stream_);
-        LOG("Audio: All FX sounds stopped");
+    mixer_.StopAll();
+    LOG("Audio: All FX sounds stopped");
+}
+
+AudioLatencyStats Audio::GetLatencyStats() {
+    AudioLatencyStats stats;
+    if (!active) return stats;
+
+    stats.deviceFrames = device_frames_;
+    stats.deviceRate = device_spec_.freq;
+    stats.fxQueuedFrames = mixer_.GetQueuedFrames();
+    stats.musicQueuedFrames = music_.GetQueuedFrames();
+    mixer_.GetCommandDelay(stats.fxCommandLastMs, stats.fxCommandMaxMs);
+
+    if (stats.deviceRate > 0) {
+        const float framesMs = 1000.0f * (stats.fxQueuedFrames + stats.deviceFrames) / stats.deviceRate;
+        stats.fxToOutputMs = stats.fxCommandLastMs + framesMs;
     }
-}
\ No newline at end of file
+    return stats;
+}
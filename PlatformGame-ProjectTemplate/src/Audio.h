@@ -1,11 +1,28 @@
 #pragma once
 
 #include "Module.h"
+#include "AudioMixer.h"
+#include "MusicStream.h"
+#include "AudioLoader.h"
+#include "AudioOffline.h"
 #include <SDL3/SDL.h>
 #include <vector>
 #include <string>
 
 #define DEFAULT_MUSIC_FADE_TIME 2.0f
+#define DEFAULT_OFFLINE_RATE 48000
+
+// Output latency figures, see Audio::GetLatencyStats
+struct AudioLatencyStats
+{
+    int deviceFrames = 0;        // device buffer size actually granted
+    int deviceRate = 0;
+    int fxQueuedFrames = 0;      // mixed frames waiting in the FX stream
+    int musicQueuedFrames = 0;   // music frames waiting in the music stream
+    float fxCommandLastMs = 0.0f;  // PlayFx -> voice started on the audio thread
+    float fxCommandMaxMs = 0.0f;   // worst one since the previous call
+    float fxToOutputMs = 0.0f;     // estimated PlayFx -> speaker: command + queued + device buffer
+};
 
 struct _Mix_Music;
 
@@ -21,13 +38,25 @@ public:
     // Called before render is available
     bool Awake();
 
+    // Collects the loader results and the buffers released by the audio thread
+    bool PreUpdate();
+
+    // Offline backend: renders the audio of this simulation tick
+    bool Update(float dt);
+
     // Called before quitting
     bool CleanUp();
 
-    // Play a music file
+    // Stream a music file (WAV or Ogg Vorbis) in a loop, fading from the current one over fadeTime seconds
     bool PlayMusic(const char* path, float fadeTime = DEFAULT_MUSIC_FADE_TIME);
 
-    // Load a WAV in memory
+    // Fade out and stop the music
+    void StopMusic(float fadeTime = DEFAULT_MUSIC_FADE_TIME);
+
+    // Loop region of the current track in frames (end exclusive), defaults to the WAV 'smpl' loop or the whole file
+    void SetMusicLoopPoints(int startFrame, int endFrame);
+
+    // Load a WAV or Ogg Vorbis effect in memory (on the loader thread, playable a few frames later)
     int LoadFx(const char* path);
 
     // Play a previously loaded WAV
@@ -36,42 +65,78 @@ public:
     // Play a previously loaded WAV with custom volume (0.0 to 1.0)
     bool PlayFx(int fx, float volume, int repeat = 0);
 
+    // Play with pan (-1 left, 1 right) and priority (higher steals voices from lower)
+    bool PlayFx(int fx, float volume, float pan, int priority, int repeat = 0);
+
+    // Maximum simultaneous voices of one effect
+    void SetFxLimit(int fx, int maxVoices);
+
     // Set volume for music (0.0 to 1.0)
     void SetMusicVolume(float volume);
 
     // Set volume for sound effects (0.0 to 1.0)
     void SetFxVolume(float volume);
 
-    // Stop all sounds on SFX stream
+    // Stop all playing sound effects
     void StopAllFx();
 
+    // Latency instrumentation (resets the worst command delay)
+    AudioLatencyStats GetLatencyStats();
+
+    // Offline backend (<audio><offline value="true"/>, or no playback device):
+    // no device, effects and music are mixed on the game thread at a fixed rate
+    bool IsOffline() const { return offline_; }
+
+    // Mix 'frames' frames into the offline output, returns the frames rendered
+    int RenderOffline(int frames);
+
+    // Rendered frames kept in memory / written to the WAV file
+    AudioOffline& GetOfflineOutput() { return offline_output_; }
+
 private:
 
-    struct SoundData {
-        SDL_AudioSpec spec{};  // source format
-        Uint8* buf{ nullptr };
-        Uint32 len{ 0 };  // bytes
+    // Sound effect converted once to float32 at the device layout and rate, stored in fxArena_.
+    // frames stays 0 until the loader delivers it
+    struct FxData {
+        std::string path;
+        size_t offset{ 0 };  // in floats
+        int frames{ 0 };
     };
 
     // Device and default output format
     SDL_AudioDeviceID device_{ 0 };
     SDL_AudioSpec     device_spec_{};
+    int               device_frames_{ 0 };
+    int               requested_frames_{ 0 }; // <audio><bufferFrames>, 0 = SDL default
+
+    // Offline backend
+    bool             offline_{ false };
+    int              offline_tick_frames_{ 0 };    // frames per Update, 0 = from dt
+    double           offline_frame_remainder_{ 0.0 };
+    AudioOffline     offline_output_;
+    float            offline_mix_[MIXER_CHUNK_FRAMES * 2];
+    float            offline_music_[MIXER_CHUNK_FRAMES * 2];
 
     // Streams
-    SDL_AudioStream* music_stream_{ nullptr }; // for background music (single)
-    SDL_AudioStream* sfx_stream_{ nullptr };   // simple shared SFX stream
+    MusicStream      music_;                   // background music, streamed
+    AudioMixer       mixer_;                   // voice pool for the sound effects
+    AudioLoader      loader_;                  // file I/O and decoding thread
+    std::string      musicPath_;               // last requested track
+    bool             streams_ready_{ false };  // EnsureStreams succeeded, the gains were posted
 
     // Loaded sounds
-    SoundData music_data_{};
-    std::vector<SoundData> sfx_; // 1-based indexing outwardly
+    std::vector<FxData> sfx_; // 1-based indexing outwardly
+    float* fxArena_{ nullptr };  // samples of every effect, back to back (SDL_malloc)
+    size_t fxArenaSize_{ 0 };    // in floats
 
     // Volume controls (0.0 to 1.0)
     float music_volume_{ 1.0f };
     float fx_volume_{ 1.0f };
 
     // helpers
-    bool LoadWavFile(const char* path, SoundData& out);
-    void FreeSound(SoundData& s);
+    void FreeArenas();
+    int  FindFx(const char* path) const;
     bool EnsureDeviceOpen();
+    bool StartOffline(int rate, const char* wavPath, bool keepInMemory);
     bool EnsureStreams();
 };
\ No newline at end of file
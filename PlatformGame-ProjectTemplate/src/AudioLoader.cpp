@@ -0,0 +1,162 @@
+#include "AudioLoader.h"
+#include "MusicStream.h"
+#include "Log.h"
+#include "MemoryTracker.h"
+
+bool AudioLoader::Start(const SDL_AudioSpec& mixSpec) {
+    if (thread_) return true;
+
+    mixSpec_ = mixSpec;
+    SDL_SetAtomicInt(&quit_, 0);
+
+    signal_ = SDL_CreateSemaphore(0);
+    if (!signal_) {
+        LOG("AudioLoader: SDL_CreateSemaphore failed: %s", SDL_GetError());
+        return false;
+    }
+
+    thread_ = SDL_CreateThread(&AudioLoader::ThreadMain, "AudioLoader", this);
+    if (!thread_) {
+        LOG("AudioLoader: SDL_CreateThread failed: %s", SDL_GetError());
+        SDL_DestroySemaphore(signal_);
+        signal_ = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void AudioLoader::Stop() {
+    if (thread_) {
+        SDL_SetAtomicInt(&quit_, 1);
+        SDL_SignalSemaphore(signal_);
+        SDL_WaitThread(thread_, nullptr);
+        thread_ = nullptr;
+    }
+    if (signal_) {
+        SDL_DestroySemaphore(signal_);
+        signal_ = nullptr;
+    }
+
+    // Free whatever was loaded but never collected
+    Job job;
+    while (jobs_.Pop(job)) {}
+    LoadedFx fx;
+    while (fxResults_.Pop(fx)) SDL_free(fx.samples);
+    LoadedMusic music;
+    while (musicResults_.Pop(music)) delete music.decoder;
+}
+
+void AudioLoader::RequestFx(int id, const char* path) {
+    Job job{};
+    job.type = JobType::FX;
+    job.id = id;
+    SDL_strlcpy(job.path, path, AUDIO_PATH_MAX);
+    Post(job);
+}
+
+void AudioLoader::RequestMusic(const char* path, float fadeTime) {
+    Job job{};
+    job.type = JobType::MUSIC;
+    job.fadeTime = fadeTime;
+    SDL_strlcpy(job.path, path, AUDIO_PATH_MAX);
+    Post(job);
+}
+
+void AudioLoader::Post(const Job& job) {
+    if (!thread_) return;
+
+    // Only loads can wait here, never the per-frame calls
+    while (!jobs_.Push(job)) SDL_Delay(1);
+    SDL_SignalSemaphore(signal_);
+}
+
+bool AudioLoader::PollFx(LoadedFx& out) {
+    return fxResults_.Pop(out);
+}
+
+bool AudioLoader::PollMusic(LoadedMusic& out) {
+    return musicResults_.Pop(out);
+}
+
+int SDLCALL AudioLoader::ThreadMain(void* data) {
+    // The decoders allocate on this thread
+    MemoryTracker::SetThreadTag(MemTag::AUDIO);
+    ((AudioLoader*)data)->Run();
+    return 0;
+}
+
+void AudioLoader::Run() {
+    while (true) {
+        SDL_WaitSemaphore(signal_);
+        if (SDL_GetAtomicInt(&quit_) != 0) break;
+
+        Job job;
+        while (jobs_.Pop(job)) {
+            if (job.type == JobType::FX) {
+                LoadedFx fx = LoadFx(job);
+                while (!fxResults_.Push(fx)) SDL_Delay(1);
+            }
+            else {
+                LoadedMusic music{};
+                music.decoder = OpenMusicDecoder(job.path);
+                music.fadeTime = job.fadeTime;
+                SDL_strlcpy(music.path, job.path, AUDIO_PATH_MAX);
+                while (!musicResults_.Push(music)) SDL_Delay(1);
+            }
+        }
+    }
+}
+
+LoadedFx AudioLoader::LoadFx(const Job& job) {
+    LoadedFx out{ job.id, nullptr, 0 };
+
+    SDL_AudioSpec spec{};
+    Uint8* buf = nullptr;
+    Uint32 len = 0;
+
+    const char* ext = SDL_strrchr(job.path, '.');
+    if (ext != nullptr && SDL_strcasecmp(ext, ".wav") != 0) {
+        // Compressed effects are short: decode the whole file
+        MusicDecoder* decoder = OpenMusicDecoder(job.path);
+        if (decoder) {
+            const int channels = decoder->spec.channels;
+            float* samples = (float*)SDL_malloc(sizeof(float) * (size_t)decoder->totalFrames * channels);
+            int frames = 0;
+            if (samples) {
+                int got;
+                while (frames < decoder->totalFrames &&
+                    (got = decoder->Read(samples + (size_t)frames * channels, decoder->totalFrames - frames)) > 0) {
+                    frames += got;
+                }
+            }
+            spec = decoder->spec;
+            buf = (Uint8*)samples;
+            len = (Uint32)(sizeof(float) * (size_t)frames * channels);
+            delete decoder;
+        }
+    }
+    else if (!SDL_LoadWAV(job.path, &spec, &buf, &len)) {
+        buf = nullptr;
+    }
+
+    if (buf == nullptr || len == 0) {
+        LOG("AudioLoader: cannot load fx %s: %s", job.path, SDL_GetError());
+        SDL_free(buf);
+        return out;
+    }
+
+    // Convert once here so the mixer only sums samples
+    Uint8* data = nullptr;
+    int dataLen = 0;
+    if (SDL_ConvertAudioSamples(&spec, buf, (int)len, &mixSpec_, &data, &dataLen)) {
+        out.samples = (float*)data;
+        out.frames = dataLen / (int)(sizeof(float) * mixSpec_.channels);
+    }
+    else {
+        LOG("AudioLoader: SDL_ConvertAudioSamples failed for %s: %s", job.path, SDL_GetError());
+    }
+
+    SDL_free(buf);
+    return out;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include "SpscQueue.h"
+
+#define AUDIO_PATH_MAX 256
+#define AUDIO_LOADER_QUEUE 64
+
+class MusicDecoder;
+
+// Effect decoded and converted to the mixer format, samples allocated with SDL_malloc
+struct LoadedFx
+{
+    int id;
+    float* samples;     // nullptr if the load failed
+    int frames;
+};
+
+// Music track opened (header parsed), ready for the music stream
+struct LoadedMusic
+{
+    MusicDecoder* decoder; // nullptr if the open failed
+    float fadeTime;
+    char path[AUDIO_PATH_MAX];
+};
+
+// Worker thread doing the file I/O and decoding for Audio.
+// Requests and results go through SPSC queues: only the game thread calls these functions.
+class AudioLoader
+{
+public:
+
+    bool Start(const SDL_AudioSpec& mixSpec);
+    void Stop();
+
+    // Queue a load, waits only if the request queue is full
+    void RequestFx(int id, const char* path);
+    void RequestMusic(const char* path, float fadeTime);
+
+    bool PollFx(LoadedFx& out);
+    bool PollMusic(LoadedMusic& out);
+
+private:
+
+    enum class JobType {
+        FX,
+        MUSIC
+    };
+
+    struct Job {
+        JobType type;
+        int id;
+        float fadeTime;
+        char path[AUDIO_PATH_MAX];
+    };
+
+    static int SDLCALL ThreadMain(void* data);
+    void Run();
+    void Post(const Job& job);
+    LoadedFx LoadFx(const Job& job);
+
+    SDL_Thread* thread_{ nullptr };
+    SDL_Semaphore* signal_{ nullptr };
+    SDL_AtomicInt quit_{};
+    SDL_AudioSpec mixSpec_{};
+
+    SpscQueue<Job, AUDIO_LOADER_QUEUE> jobs_;
+    SpscQueue<LoadedFx, AUDIO_LOADER_QUEUE> fxResults_;
+    SpscQueue<LoadedMusic, AUDIO_LOADER_QUEUE> musicResults_;
+};
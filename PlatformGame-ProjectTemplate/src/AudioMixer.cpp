@@ -0,0 +1,353 @@
+#include "AudioMixer.h"
+#include "Log.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MIXER_SSE 1
+#endif
+
+// --- Mix kernels (dst += src * gain), interleaved float samples
+
+// Stereo: gains alternate L, R
+static void MixStereo(float* dst, const float* src, int frames, float gainL, float gainR)
+{
+    int i = 0;
+    const int samples = frames * 2;
+#ifdef MIXER_SSE
+    const __m128 gain = _mm_setr_ps(gainL, gainR, gainL, gainR);
+    for (; i + 4 <= samples; i += 4) {
+        __m128 d = _mm_loadu_ps(dst + i);
+        __m128 s = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(s, gain)));
+    }
+#endif
+    for (; i < samples; i += 2) {
+        dst[i] += src[i] * gainL;
+        dst[i + 1] += src[i + 1] * gainR;
+    }
+}
+
+// Any channel layout with a single gain
+static void MixScaled(float* dst, const float* src, int samples, float gain)
+{
+    int i = 0;
+#ifdef MIXER_SSE
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= samples; i += 4) {
+        __m128 d = _mm_loadu_ps(dst + i);
+        __m128 s = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(s, g)));
+    }
+#endif
+    for (; i < samples; ++i) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+// Apply the master gain and hard clip the mix to [-1, 1]
+static void GainClip(float* buf, int samples, float gain)
+{
+    int i = 0;
+#ifdef MIXER_SSE
+    const __m128 g = _mm_set1_ps(gain);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= samples; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(buf + i), g);
+        _mm_storeu_ps(buf + i, _mm_min_ps(_mm_max_ps(v, lo), hi));
+    }
+#endif
+    for (; i < samples; ++i) {
+        float v = buf[i] * gain;
+        if (v < -1.0f) v = -1.0f;
+        else if (v > 1.0f) v = 1.0f;
+        buf[i] = v;
+    }
+}
+
+AudioMixer::AudioMixer() {
+    for (int i = 0; i < MIXER_MAX_FX; ++i) fxLimit_[i] = MIXER_DEFAULT_FX_LIMIT;
+}
+
+bool AudioMixer::Init(SDL_AudioDeviceID device, const SDL_AudioSpec& deviceSpec) {
+    if (stream_) return true;
+
+    if (deviceSpec.channels <= 0 || deviceSpec.channels > 8) {
+        LOG("AudioMixer: unsupported channel count %d", deviceSpec.channels);
+        return false;
+    }
+    channels_ = deviceSpec.channels;
+
+    // The mixer always produces float32 at the device layout and rate
+    SDL_AudioSpec mixSpec{};
+    mixSpec.format = SDL_AUDIO_F32;
+    mixSpec.channels = deviceSpec.channels;
+    mixSpec.freq = deviceSpec.freq;
+
+    stream_ = SDL_CreateAudioStream(&mixSpec, &deviceSpec);
+    if (!stream_) {
+        LOG("AudioMixer: SDL_CreateAudioStream failed: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetAudioStreamGetCallback(stream_, &AudioMixer::GetCallback, this);
+
+    // Without a device the stream stays unbound and is pulled by Render
+    if (device != 0 && !SDL_BindAudioStream(device, stream_)) {
+        LOG("AudioMixer: SDL_BindAudioStream failed: %s", SDL_GetError());
+        SDL_DestroyAudioStream(stream_);
+        stream_ = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void AudioMixer::Shutdown() {
+    if (stream_) {
+        SDL_DestroyAudioStream(stream_);
+        stream_ = nullptr;
+    }
+
+    // The audio thread is gone: apply what is left so every arena ends up retired or current
+    ProcessCommands();
+    for (auto& v : voices_) v = Voice{};
+    SDL_SetAtomicInt(&activeVoices_, 0);
+}
+
+bool AudioMixer::Post(const Command& command) {
+    if (!stream_) return false;
+    return commands_.Push(command);
+}
+
+bool AudioMixer::Play(int fx, size_t offset, int frames, float volume, float pan, int priority, int repeat) {
+    if (frames <= 0) return false;
+
+    Command c{};
+    c.type = CommandType::PLAY;
+    c.fx = fx;
+    c.offset = offset;
+    c.frames = frames;
+    c.volume = volume;
+    c.pan = pan;
+    c.priority = priority;
+    c.repeat = repeat;
+    c.postedNs = SDL_GetTicksNS();
+    return Post(c);
+}
+
+void AudioMixer::SetArena(float* samples) {
+    Command c{};
+    c.type = CommandType::SET_ARENA;
+    c.arena = samples;
+    if (!stream_) {
+        // No audio thread to hand it to, swap directly
+        if (arena_ != samples && arena_ != nullptr) retired_.Push(arena_);
+        arena_ = samples;
+        return;
+    }
+
+    // Load time only, waiting for room is fine here
+    while (!commands_.Push(c)) SDL_Delay(1);
+}
+
+float* AudioMixer::CollectRetired() {
+    float* samples = nullptr;
+    return retired_.Pop(samples) ? samples : nullptr;
+}
+
+void AudioMixer::StopFx(int fx) {
+    Command c{};
+    c.type = CommandType::STOP_FX;
+    c.fx = fx;
+    Post(c);
+}
+
+void AudioMixer::StopAll() {
+    Command c{};
+    c.type = CommandType::STOP_ALL;
+    Post(c);
+}
+
+void AudioMixer::SetFxLimit(int fx, int maxVoices) {
+    Command c{};
+    c.type = CommandType::SET_FX_LIMIT;
+    c.fx = fx;
+    c.frames = maxVoices;
+    Post(c);
+}
+
+void AudioMixer::SetGain(float gain) {
+    Command c{};
+    c.type = CommandType::SET_GAIN;
+    c.volume = gain;
+    Post(c);
+}
+
+int AudioMixer::GetActiveVoices() {
+    return SDL_GetAtomicInt(&activeVoices_);
+}
+
+int AudioMixer::GetQueuedFrames() {
+    if (!stream_) return 0;
+    return SDL_GetAudioStreamQueued(stream_) / (int)(sizeof(float) * channels_);
+}
+
+int AudioMixer::Render(float* out, int frames) {
+    if (!stream_) return 0;
+
+    // Runs the get callback on the calling thread
+    const int frameBytes = (int)sizeof(float) * channels_;
+    int bytes = SDL_GetAudioStreamData(stream_, out, frames * frameBytes);
+    return bytes > 0 ? bytes / frameBytes : 0;
+}
+
+void AudioMixer::GetCommandDelay(float& lastMs, float& maxMs) {
+    lastMs = SDL_GetAtomicInt(&lastDelayUs_) / 1000.0f;
+    maxMs = SDL_SetAtomicInt(&maxDelayUs_, 0) / 1000.0f; // returns the previous value
+}
+
+// Audio thread (or the game thread once the stream is destroyed)
+void AudioMixer::ProcessCommands() {
+    Command c;
+    while (commands_.Pop(c)) {
+        switch (c.type)
+        {
+        case CommandType::PLAY:
+            StartVoice(c);
+            break;
+        case CommandType::STOP_FX:
+            for (auto& v : voices_) {
+                if (v.fx == c.fx) v.active = false;
+            }
+            break;
+        case CommandType::STOP_ALL:
+            for (auto& v : voices_) v.active = false;
+            break;
+        case CommandType::SET_FX_LIMIT:
+            if (c.fx >= 0 && c.fx < MIXER_MAX_FX) fxLimit_[c.fx] = c.frames < 1 ? 1 : c.frames;
+            break;
+        case CommandType::SET_GAIN:
+            gain_ = c.volume;
+            break;
+        case CommandType::SET_ARENA:
+            // If the retire queue is full the old arena leaks rather than blocking the audio thread
+            if (arena_ != nullptr && arena_ != c.arena) retired_.Push(arena_);
+            arena_ = c.arena;
+            break;
+        }
+    }
+}
+
+void AudioMixer::StartVoice(const Command& c) {
+    // Time spent in the command queue, the mixed chunk then goes through the stream and the device buffer
+    int delayUs = (int)((SDL_GetTicksNS() - c.postedNs) / 1000);
+    SDL_SetAtomicInt(&lastDelayUs_, delayUs);
+    if (delayUs > SDL_GetAtomicInt(&maxDelayUs_)) SDL_SetAtomicInt(&maxDelayUs_, delayUs);
+
+    int index = FindVoice(c.fx, c.priority);
+    if (index < 0) return;
+
+    float pan = c.pan;
+    if (pan < -1.0f) pan = -1.0f;
+    if (pan > 1.0f) pan = 1.0f;
+
+    Voice& v = voices_[index];
+    v.offset = c.offset;
+    v.frames = c.frames;
+    v.position = 0;
+    v.loopsLeft = c.repeat;
+    // Balance pan: the centre keeps full gain on both sides
+    v.gainL = c.volume * (pan > 0.0f ? 1.0f - pan : 1.0f);
+    v.gainR = c.volume * (pan < 0.0f ? 1.0f + pan : 1.0f);
+    v.fx = c.fx;
+    v.priority = c.priority;
+    v.age = sequence_++;
+    v.active = true;
+}
+
+int AudioMixer::FindVoice(int fx, int priority) {
+    // Per effect limit: restart the oldest instance of the same effect
+    int limit = (fx >= 0 && fx < MIXER_MAX_FX) ? fxLimit_[fx] : MIXER_DEFAULT_FX_LIMIT;
+    int instances = 0;
+    int oldestSame = -1;
+    int freeVoice = -1;
+    int victim = -1;
+
+    for (int i = 0; i < MIXER_MAX_VOICES; ++i) {
+        const Voice& v = voices_[i];
+        if (!v.active) {
+            if (freeVoice < 0) freeVoice = i;
+            continue;
+        }
+        if (v.fx == fx) {
+            ++instances;
+            if (oldestSame < 0 || v.age < voices_[oldestSame].age) oldestSame = i;
+        }
+        // Steal candidate: lowest priority, then oldest
+        if (victim < 0 || v.priority < voices_[victim].priority ||
+            (v.priority == voices_[victim].priority && v.age < voices_[victim].age)) {
+            victim = i;
+        }
+    }
+
+    if (instances >= limit) return oldestSame;
+    if (freeVoice >= 0) return freeVoice;
+    if (victim >= 0 && voices_[victim].priority <= priority) return victim;
+    return -1;
+}
+
+// Runs on the SDL audio thread
+void SDLCALL AudioMixer::GetCallback(void* userdata, SDL_AudioStream* stream, int additional_amount, int /*total_amount*/) {
+    AudioMixer* mixer = (AudioMixer*)userdata;
+    mixer->ProcessCommands();
+    const int frameBytes = (int)sizeof(float) * mixer->channels_;
+
+    int framesLeft = additional_amount / frameBytes;
+    while (framesLeft > 0) {
+        int frames = framesLeft < MIXER_CHUNK_FRAMES ? framesLeft : MIXER_CHUNK_FRAMES;
+        mixer->Mix(mixer->mixBuffer_, frames);
+        SDL_PutAudioStreamData(stream, mixer->mixBuffer_, frames * frameBytes);
+        framesLeft -= frames;
+    }
+
+    int active = 0;
+    for (const auto& v : mixer->voices_) {
+        if (v.active) ++active;
+    }
+    SDL_SetAtomicInt(&mixer->activeVoices_, active);
+}
+
+void AudioMixer::Mix(float* out, int frames) {
+    SDL_memset(out, 0, sizeof(float) * frames * channels_);
+    if (arena_ == nullptr) return;
+
+    for (auto& v : voices_) {
+        if (!v.active) continue;
+
+        int done = 0;
+        while (done < frames && v.active) {
+            int count = v.frames - v.position;
+            if (count > frames - done) count = frames - done;
+
+            const float* src = arena_ + v.offset + (size_t)v.position * channels_;
+            float* dst = out + (size_t)done * channels_;
+            if (channels_ == 2) MixStereo(dst, src, count, v.gainL, v.gainR);
+            else MixScaled(dst, src, count * channels_, 0.5f * (v.gainL + v.gainR));
+
+            v.position += count;
+            done += count;
+
+            if (v.position >= v.frames) {
+                if (v.loopsLeft > 0) {
+                    --v.loopsLeft;
+                    v.position = 0;
+                }
+                else {
+                    v.active = false;
+                }
+            }
+        }
+    }
+
+    GainClip(out, frames * channels_, gain_);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include "SpscQueue.h"
+
+#define MIXER_MAX_VOICES 32
+#define MIXER_MAX_FX 64
+#define MIXER_DEFAULT_FX_LIMIT 4     // simultaneous voices of the same effect
+#define MIXER_CHUNK_FRAMES 1024      // frames mixed per pass of the callback
+#define MIXER_QUEUE_SIZE 256         // commands in flight between the game and audio threads
+
+// Software mixer: a fixed pool of voices summed into one float stream bound to the device.
+// Voices read from a shared sample arena (float32 with the device channel count and rate),
+// offsets are in floats from the start of the arena.
+// The game thread only posts commands, the voices are owned by the audio thread.
+class AudioMixer
+{
+public:
+
+    AudioMixer();
+
+    bool Init(SDL_AudioDeviceID device, const SDL_AudioSpec& deviceSpec);
+    void Shutdown();
+
+    // Queue a voice start, false if the command queue is full. Never locks nor allocates.
+    bool Play(int fx, size_t offset, int frames, float volume, float pan, int priority, int repeat);
+
+    // Swap to a new arena holding the old samples at the same offsets.
+    // The old one comes back through CollectRetired once the audio thread stops using it.
+    void SetArena(float* samples);
+    float* CollectRetired();
+
+    void StopFx(int fx);
+    void StopAll();
+
+    // Maximum voices of one effect playing at the same time (the oldest one is restarted)
+    void SetFxLimit(int fx, int maxVoices);
+
+    // Master gain of the mix
+    void SetGain(float gain);
+
+    // Offline backend (Init with device 0): mix 'frames' frames into 'out' on the calling thread,
+    // which then acts as the audio thread. Returns the frames written
+    int Render(float* out, int frames);
+
+    // Voices playing at the end of the last mixed chunk
+    int GetActiveVoices();
+
+    // Instrumentation: frames waiting in the stream, and the time a Play command
+    // spent in the queue before its voice started (last one and worst since the last call)
+    int GetQueuedFrames();
+    void GetCommandDelay(float& lastMs, float& maxMs);
+
+private:
+
+    enum class CommandType {
+        PLAY,
+        STOP_FX,
+        STOP_ALL,
+        SET_FX_LIMIT,
+        SET_GAIN,
+        SET_ARENA
+    };
+
+    struct Command {
+        CommandType type;
+        int fx;
+        int frames;
+        int priority;
+        int repeat;
+        size_t offset;
+        float volume;
+        float pan;
+        float* arena;
+        Uint64 postedNs;      // PLAY: SDL_GetTicksNS() when posted
+    };
+
+    struct Voice {
+        size_t offset{ 0 };
+        int frames{ 0 };
+        int position{ 0 };      // next frame to mix
+        int loopsLeft{ 0 };
+        float gainL{ 1.0f };
+        float gainR{ 1.0f };
+        int fx{ 0 };
+        int priority{ 0 };
+        Uint32 age{ 0 };        // start sequence, lower is older
+        bool active{ false };
+    };
+
+    static void SDLCALL GetCallback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount);
+    bool Post(const Command& command);
+    void ProcessCommands();
+    void StartVoice(const Command& command);
+    void Mix(float* out, int frames);
+    int  FindVoice(int fx, int priority);
+
+    SDL_AudioStream* stream_{ nullptr };
+    int channels_{ 2 };
+
+    SpscQueue<Command, MIXER_QUEUE_SIZE> commands_;  // game -> audio
+    SpscQueue<float*, MIXER_QUEUE_SIZE> retired_;    // audio -> game
+
+    // Audio thread state
+    float* arena_{ nullptr };
+    float gain_{ 1.0f };
+    Voice voices_[MIXER_MAX_VOICES];
+    int fxLimit_[MIXER_MAX_FX];
+    Uint32 sequence_{ 0 };
+    SDL_AtomicInt activeVoices_{};
+    SDL_AtomicInt lastDelayUs_{};
+    SDL_AtomicInt maxDelayUs_{};
+
+    float mixBuffer_[MIXER_CHUNK_FRAMES * 8]; // up to 7.1 output
+};
@@ -0,0 +1,83 @@
+#include "AudioOffline.h"
+#include "Log.h"
+
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_HEADER_BYTES 44
+
+AudioOffline::~AudioOffline() {
+    Close();
+}
+
+bool AudioOffline::Open(const SDL_AudioSpec& spec, const char* wavPath, bool keepInMemory) {
+    Close();
+
+    spec_ = spec;
+    keepInMemory_ = keepInMemory;
+    framesWritten_ = 0;
+    samples_.clear();
+
+    if (wavPath != nullptr && wavPath[0] != '\0') {
+        wav_ = SDL_IOFromFile(wavPath, "wb");
+        if (!wav_) {
+            LOG("AudioOffline: cannot create %s: %s", wavPath, SDL_GetError());
+            return false;
+        }
+        // Sizes are patched in Close
+        if (!WriteHeader(0)) {
+            LOG("AudioOffline: cannot write %s: %s", wavPath, SDL_GetError());
+            SDL_CloseIO(wav_);
+            wav_ = nullptr;
+            return false;
+        }
+        LOG("AudioOffline: writing %s (%d Hz, %d channels)", wavPath, spec_.freq, spec_.channels);
+    }
+
+    return true;
+}
+
+void AudioOffline::Close() {
+    if (!wav_) return;
+
+    const Uint64 dataBytes = framesWritten_ * sizeof(float) * spec_.channels;
+    if (SDL_SeekIO(wav_, 0, SDL_IO_SEEK_SET) < 0 || !WriteHeader((Uint32)dataBytes)) {
+        LOG("AudioOffline: cannot finish the WAV header: %s", SDL_GetError());
+    }
+    SDL_CloseIO(wav_);
+    wav_ = nullptr;
+}
+
+void AudioOffline::Write(const float* samples, int frames) {
+    if (frames <= 0) return;
+
+    const size_t count = (size_t)frames * spec_.channels;
+    if (keepInMemory_) samples_.insert(samples_.end(), samples, samples + count);
+
+    // The samples are written as they are in memory: little-endian hosts only
+    if (wav_ && SDL_WriteIO(wav_, samples, sizeof(float) * count) != sizeof(float) * count) {
+        LOG("AudioOffline: write failed, closing the file: %s", SDL_GetError());
+        Close();
+    }
+
+    framesWritten_ += (Uint64)frames;
+}
+
+bool AudioOffline::WriteHeader(Uint32 dataBytes) {
+    const Uint16 channels = (Uint16)spec_.channels;
+    const Uint32 rate = (Uint32)spec_.freq;
+    const Uint16 blockAlign = (Uint16)(channels * sizeof(float));
+
+    bool ok = SDL_WriteU32LE(wav_, 0x46464952);                   // "RIFF"
+    ok = ok && SDL_WriteU32LE(wav_, WAV_HEADER_BYTES - 8 + dataBytes);
+    ok = ok && SDL_WriteU32LE(wav_, 0x45564157);                  // "WAVE"
+    ok = ok && SDL_WriteU32LE(wav_, 0x20746d66);                  // "fmt "
+    ok = ok && SDL_WriteU32LE(wav_, 16);
+    ok = ok && SDL_WriteU16LE(wav_, WAV_FORMAT_IEEE_FLOAT);
+    ok = ok && SDL_WriteU16LE(wav_, channels);
+    ok = ok && SDL_WriteU32LE(wav_, rate);
+    ok = ok && SDL_WriteU32LE(wav_, rate * blockAlign);
+    ok = ok && SDL_WriteU16LE(wav_, blockAlign);
+    ok = ok && SDL_WriteU16LE(wav_, 32);
+    ok = ok && SDL_WriteU32LE(wav_, 0x61746164);                  // "data"
+    ok = ok && SDL_WriteU32LE(wav_, dataBytes);
+    return ok;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <vector>
+
+// Sink of the offline audio backend: keeps the rendered frames in memory
+// and/or writes them to a float32 WAV file
+class AudioOffline
+{
+public:
+
+    ~AudioOffline();
+
+    // wavPath may be nullptr (no file), keepInMemory stores every frame in GetSamples
+    bool Open(const SDL_AudioSpec& spec, const char* wavPath, bool keepInMemory);
+
+    // Finishes the WAV header and closes the file
+    void Close();
+
+    // Interleaved float32 frames at the spec given to Open
+    void Write(const float* samples, int frames);
+
+    const std::vector<float>& GetSamples() const { return samples_; }
+    void ClearSamples() { samples_.clear(); }
+
+    Uint64 GetFramesWritten() const { return framesWritten_; }
+
+private:
+
+    bool WriteHeader(Uint32 dataBytes);
+
+    SDL_IOStream* wav_{ nullptr };
+    SDL_AudioSpec spec_{};
+    bool keepInMemory_{ false };
+    Uint64 framesWritten_{ 0 };
+    std::vector<float> samples_;
+};
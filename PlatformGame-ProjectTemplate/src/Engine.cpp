@@ -1,6 +1,6 @@
 ﻿#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <cstring>
+#include <cstdlib>
 
 #include "Engine.h"
 #include "Window.h"
@@ -79,16 +79,65 @@ bool Engine::Awake() {
     LOG("Engine::Awake");
 
     //L05 TODO 2: Add the LoadConfig() method here
-    LoadConfig();
+    // A replay runs with the config, seed and level it was recorded with
+    if (!replayPath.empty()) {
+        if (!input->StartReplay(replayPath.c_str())) return false;
+        const InputRecordingHeader& header = input->GetReplayHeader();
+        configFile.load_string(header.config.c_str());
+        randomSeed = header.seed;
+        fixedDt = header.fixedDt;
+        scene->startLevel = header.level;
+    }
+    else {
+        LoadConfig();
+        randomSeed = (Uint32)SDL_GetTicksNS();
+    }
+    srand(randomSeed);
+
     // L05: TODO 3: Read the title from the config file and set the variable gameTitle, read targetFrameRate and set the variables
     gameTitle = configFile.child("config").child("engine").child("title").child_value();
     targetFrameRate = configFile.child("config").child("engine").child("targetFrameRate").attribute("value").as_int();
 
+    // Replays are for measuring: no frame cap
+    if (!replayPath.empty()) targetFrameRate = 0;
+
+    if (!recordPath.empty()) {
+        InputRecordingHeader header;
+        header.seed = randomSeed;
+        header.fixedDt = targetFrameRate > 0 ? 1000.0f / targetFrameRate : 1000.0f / 60.0f;
+        header.level = scene->startLevel;
+
+        size_t size = 0;
+        void* text = SDL_LoadFile("config.xml", &size);
+        if (text) {
+            header.config.assign((const char*)text, size);
+            SDL_free(text);
+        }
+
+        if (!input->StartRecording(recordPath.c_str(), header)) return false;
+        fixedDt = header.fixedDt;
+    }
+
+    size_t arenaKb = configFile.child("config").child("engine").child("frameArena").attribute("kb").as_uint(FRAME_ARENA_DEFAULT_SIZE / 1024);
+    if (!frameArena.Init(arenaKb * 1024)) return false;
+
+    size_t levelKb = configFile.child("config").child("engine").child("levelArena").attribute("kb").as_uint(LEVEL_ARENA_BLOCK_SIZE / 1024);
+    if (!levelArena.Init(levelKb * 1024)) return false;
+
+    perfHud.SetVisible(configFile.child("config").child("engine").child("hud").attribute("visible").as_bool(false));
+
+    // Fixed steps keep the simulation the same from run to run
+    if (fixedDt > 0.0f) {
+        dt = fixedDt;
+        LOG("Engine: fixed dt %.3f ms", fixedDt);
+    }
+
     //Iterates the module list and calls Awake on each module
     bool result = true;
     for (const auto& module : moduleList) {
         // L05: TODO 4: Call the LoadParameters function for each module
         module->LoadParameters(configFile.child("config").child(module.get()->name.c_str()));
+        MemScope scope(module->memTag);
         result = module->Awake();
 
         if (!result) {
@@ -118,18 +167,40 @@ bool Engine::Start() {
     //Iterates the module list and calls Start on each module
     bool result = true;
     for (const auto& module : moduleList) {
+        MemScope scope(module->memTag);
         result = module->Start();
         if (!result) {
             break;
         }
     }
 
+    // A replay on another level than the recorded one would not reproduce the run
+    if (result && !replayPath.empty() && scene->GetCurrentLevel() != scene->startLevel) {
+        LOG("Replay: level %d could not be loaded", scene->startLevel);
+        result = false;
+    }
+
+    // Module timings for the profiler and the HUD, in moduleList order
+    frameModuleMs.assign(moduleList.size(), 0.0);
+    int index = 0;
+    for (const auto& module : moduleList) {
+        perfHud.SetModuleName(index++, module->name.c_str());
+    }
+    loopTime.Start();
+
     // L2: TODO 3: Log the result of the timer
     LOG("Timer App Start(): %f", timer.ReadMSec());
 
     return result;
 }
 
+void Engine::ParseCommandLine(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--record") == 0) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0) replayPath = argv[++i];
+    }
+}
+
 // Called each loop iteration
 bool Engine::Update() {
 
@@ -148,6 +219,8 @@ bool Engine::Update() {
         if (showDebugHelp) {
             LOG("=== DEBUG HELP MENU ===");
             LOG("H     - Toggle this help");
+            LOG("F7    - Performance HUD [%s]", perfHud.IsVisible() ? "ON" : "OFF");
+            LOG("F8    - Memory report (diff with the previous one)");
             LOG("F9    - Show/Hide colliders [%s]", debugColliders ? "ON" : "OFF");
             LOG("F10   - God Mode [%s]", godMode ? "ON" : "OFF");
             LOG("F11   - Toggle FPS cap [%d]", targetFrameRate);
@@ -159,6 +232,21 @@ bool Engine::Update() {
         }
     }
 
+    // Performance HUD with F7
+    if (input->GetKey(SDL_SCANCODE_F7) == KEY_DOWN) {
+        perfHud.Toggle();
+        LOG("Performance HUD: %s", perfHud.IsVisible() ? "ON" : "OFF");
+    }
+
+    // Memory per subsystem with F8, compared with the previous F8
+    if (input->GetKey(SDL_SCANCODE_F8) == KEY_DOWN) {
+        MemorySnapshot snapshot = GetMemorySnapshot();
+        MemoryTracker::LogSnapshot(snapshot, "report");
+        if (hasMemoryReport) MemoryTracker::LogDiff(lastMemoryReport, snapshot, "since the previous report");
+        lastMemoryReport = snapshot;
+        hasMemoryReport = true;
+    }
+
     // Toggle collider visualization with F9
     if (input->GetKey(SDL_SCANCODE_F9) == KEY_DOWN) {
         debugColliders = !debugColliders;
@@ -193,12 +281,24 @@ bool Engine::Update() {
     if (ret == true)
         ret = PreUpdate();
 
+    // Oldest key event picked up this frame
+    int eventCount = 0;
+    const InputEvent* events = input->GetEvents(eventCount);
+    Uint64 eventTime = eventCount > 0 ? events[0].timestamp : 0;
+
     if (ret == true)
         ret = DoUpdate();
+    Uint64 tickTime = SDL_GetTicksNS();
 
     if (ret == true)
         ret = PostUpdate();
 
+    if (eventTime != 0) {
+        inputToPickup.Add((input->GetFrameEnd() - eventTime) / 1e6f);
+        inputToTick.Add((tickTime - eventTime) / 1e6f);
+        inputToPresent.Add((render->GetLastPresentTime() - eventTime) / 1e6f);
+    }
+
     FinishUpdate();
     return ret;
 }
@@ -219,22 +319,80 @@ bool Engine::CleanUp() {
     //Iterates the module list and calls CleanUp on each module
     bool result = true;
     for (const auto& module : moduleList) {
+        MemScope scope(module->memTag);
         result = module->CleanUp();
         if (!result) {
             break;
         }
     }
 
+    // Whatever a subsystem still reports now was not released by its CleanUp
+    frameArena.Release();
+    levelArena.Release();
+    RefreshMemoryUsage();
+    MemoryTracker::LogLeaks();
+
     // L2: TODO 3: Log the result of the timer
     LOG("Timer App CleanUp(): %f", timer.ReadMSec());
 
     return result;
 }
 
+// Physics, entities and the arenas are polled, the other subsystems report their changes themselves
+void Engine::RefreshMemoryUsage() {
+    int64_t physicsBytes = 0;
+    int bodies = 0;
+    if (physics) physics->GetMemoryUsage(physicsBytes, bodies);
+    MemoryTracker::Set(MemTag::PHYSICS, physicsBytes, bodies);
+
+    if (entityManager) MemoryTracker::Set(MemTag::ENTITIES, 0, (int64_t)entityManager->entities.size());
+
+    MemoryTracker::Set(MemTag::ARENAS, (int64_t)(frameArena.GetCapacity() + levelArena.GetReserved()), 2);
+}
+
+MemorySnapshot Engine::GetMemorySnapshot() {
+    RefreshMemoryUsage();
+    return MemoryTracker::Snapshot();
+}
+
+InputLatencyStats Engine::GetInputLatencyStats() const {
+    auto percentiles = [](const RollingStats& stats) {
+        LatencyPercentiles p;
+        p.p50 = stats.Percentile(50.0f);
+        p.p95 = stats.Percentile(95.0f);
+        p.p99 = stats.Percentile(99.0f);
+        return p;
+    };
+
+    InputLatencyStats stats;
+    stats.pickup = percentiles(inputToPickup);
+    stats.tick = percentiles(inputToTick);
+    stats.present = percentiles(inputToPresent);
+    stats.samples = inputToPresent.Count();
+    return stats;
+}
+
+void Engine::SetModuleProfiling(bool enabled, int reserveFrames) {
+    profiling = enabled;
+    moduleTimings.clear();
+    frameTimings.clear();
+    frameModuleMs.assign(moduleList.size(), 0.0);
+    if (!enabled) return;
+
+    frameTimings.reserve(reserveFrames);
+    for (const auto& module : moduleList) {
+        ModuleTimings timings;
+        timings.name = module->name;
+        timings.frameMs.reserve(reserveFrames);
+        moduleTimings.push_back(timings);
+    }
+}
+
 // ---------------------------------------------
 void Engine::PrepareUpdate()
 {
     frameTime.Start();
+    timingModules = profiling || perfHud.IsVisible();
 }
 
 // ---------------------------------------------
@@ -243,6 +401,16 @@ void Engine::FinishUpdate()
     // FPS calculation
     double currentDt = frameTime.ReadMs();
 
+    if (profiling) {
+        frameTimings.push_back((float)currentDt);
+        for (size_t i = 0; i < moduleTimings.size(); ++i) {
+            moduleTimings[i].frameMs.push_back((float)frameModuleMs[i]);
+        }
+    }
+
+    // Dynamic internal resolution follows the work of the frame, the cap delay is not counted
+    render->AdaptResolution((float)currentDt, targetFrameRate > 0 ? 1000.0f / targetFrameRate : 1000.0f / 60.0f);
+
     // Cap framerate if needed
     if (targetFrameRate > 0) {
         cappedMs = 1000 / targetFrameRate;
@@ -260,23 +428,35 @@ void Engine::FinishUpdate()
     secondsSinceStartup = startupTime.ReadSec();
 
     // Amount of ms took the last update (dt)
-    dt = (float)frameTime.ReadMs();
+    lastFrameMs = (float)frameTime.ReadMs();
+    dt = fixedDt > 0.0f ? fixedDt : lastFrameMs;
 
-    // Calculate average FPS
-    if (lastSecFrameTime.ReadMs() > 1000) {
+    // Calculate average FPS, the title is updated at the same time
+    bool refreshTitle = lastSecFrameTime.ReadMs() > 1000;
+    if (refreshTitle) {
         lastSecFrameTime.Start();
         framesPerSecond = lastSecFrameCount;
         lastSecFrameCount = 0;
 
-        // Calculate true average (cumulative)
-        if (averageFps == 0.0f) {
-            averageFps = (float)framesPerSecond;
-        }
-        else {
-            averageFps = (averageFps + framesPerSecond) / 2.0f;
-        }
+        // True average since the first frame (a pairwise mean of the seconds weighted the last one by half)
+        double loopMs = loopTime.ReadMs();
+        averageFps = loopMs > 0.0 ? (float)(frameCount * 1000.0 / loopMs) : 0.0f;
+
+        inputLatency = GetInputLatencyStats();
     }
 
+    if (refreshTitle) UpdateTitle();
+
+    // The HUD graph shows the whole frame, frame cap included
+    if (perfHud.IsVisible()) perfHud.AddFrame(lastFrameMs, frameModuleMs.data(), (int)frameModuleMs.size());
+    for (double& ms : frameModuleMs) ms = 0.0;
+
+    // Everything allocated from the frame arena this frame is released here
+    frameArena.Reset();
+}
+
+void Engine::UpdateTitle()
+{
     // Get vsync status
     bool vsyncEnabled = false;
     if (render && render->renderer) {
@@ -287,15 +467,13 @@ void Engine::FinishUpdate()
 
     // Format window title with FPS info
     // Format: "FPS: XX / Avg.FPS: XX.XX / Last-frame MS: XX.XX / Vsync: on/off"
-    std::stringstream ss;
-    ss << gameTitle
-        << " | FPS: " << framesPerSecond
-        << " / Avg.FPS: " << std::fixed << std::setprecision(2) << averageFps
-        << " / Last-frame MS: " << std::fixed << std::setprecision(2) << dt
-        << " / Vsync: " << (vsyncEnabled ? "on" : "off");
-
-    std::string titleStr = ss.str();
-    window->SetTitle(titleStr.c_str());
+    const size_t titleSize = 512;
+    char* title = static_cast<char*>(frameArena.Allocate(titleSize, 1));
+    SDL_snprintf(title, titleSize, "%s | FPS: %u / Avg.FPS: %.2f / Last-frame MS: %.2f / Vsync: %s / Input->present p50/p95: %.1f/%.1f ms",
+        gameTitle.c_str(), framesPerSecond, averageFps, lastFrameMs, vsyncEnabled ? "on" : "off",
+        inputLatency.present.p50, inputLatency.present.p95);
+
+    window->SetTitle(title);
 }
 
 
@@ -304,8 +482,12 @@ bool Engine::PreUpdate()
 {
     //Iterates the module list and calls PreUpdate on each module
     bool result = true;
+    int index = 0;
     for (const auto& module : moduleList) {
+        MemScope scope(module->memTag);
+        if (timingModules) moduleTimer.Start();
         result = module->PreUpdate();
+        if (timingModules) frameModuleMs[index++] += moduleTimer.ReadMs();
         if (!result) {
             break;
         }
@@ -319,8 +501,12 @@ bool Engine::DoUpdate()
 {
     //Iterates the module list and calls Update on each module
     bool result = true;
+    int index = 0;
     for (const auto& module : moduleList) {
+        MemScope scope(module->memTag);
+        if (timingModules) moduleTimer.Start();
         result = module->Update(dt);
+        if (timingModules) frameModuleMs[index++] += moduleTimer.ReadMs();
         if (!result) {
             break;
         }
@@ -334,8 +520,12 @@ bool Engine::PostUpdate()
 {
     //Iterates the module list and calls PostUpdate on each module
     bool result = true;
+    int index = 0;
     for (const auto& module : moduleList) {
+        MemScope scope(module->memTag);
+        if (timingModules) moduleTimer.Start();
         result = module->PostUpdate();
+        if (timingModules) frameModuleMs[index++] += moduleTimer.ReadMs();
         if (!result) {
             break;
         }
@@ -364,6 +554,33 @@ void Engine::DrawDebugHelp()
     }
 }
 
+void Engine::DrawPerfHud()
+{
+    if (!perfHud.IsVisible()) return;
+
+    if (perfHud.NeedsRefresh()) {
+        MemorySnapshot memory = GetMemorySnapshot();
+
+        PerfHudStats stats;
+        stats.fps = (int)framesPerSecond;
+        stats.averageFps = averageFps;
+        RenderCounters renderCounters = render->GetStats().Total();
+        stats.drawCalls = renderCounters.drawCalls;
+        stats.sprites = renderCounters.sprites;
+        stats.textureSwitches = renderCounters.textureSwitches;
+        stats.stateChanges = renderCounters.stateChanges;
+        stats.primitives = renderCounters.primitives;
+        stats.culled = renderCounters.culled;
+        render->GetInternalResolution(stats.internalWidth, stats.internalHeight);
+        stats.bodies = (int)memory.tags[(int)MemTag::PHYSICS].count;
+        stats.trackedBytes = memory.TotalBytes();
+        stats.heapBytes = memory.TotalHeapBytes();
+        perfHud.SetStats(stats);
+    }
+
+    perfHud.Draw(render->renderer);
+}
+
 // Load config from XML file
 bool Engine::LoadConfig()
 {
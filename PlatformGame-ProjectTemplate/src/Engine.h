@@ -2,9 +2,16 @@
 
 #include <memory>
 #include <list>
+#include <string>
+#include <vector>
 #include "Module.h"
 #include "Timer.h"
 #include "PerfTimer.h"
+#include "Stats.h"
+#include "FrameArena.h"
+#include "LevelArena.h"
+#include "MemoryTracker.h"
+#include "PerfHud.h"
 #include "pugixml.hpp"
 #include <SDL3/SDL.h>
 
@@ -20,6 +27,31 @@ class Map;
 //L08 TODO 2: Add Physics module
 class Physics;
 
+struct LatencyPercentiles
+{
+	float p50 = 0.0f;
+	float p95 = 0.0f;
+	float p99 = 0.0f;
+};
+
+// Input latency in ms, from the SDL timestamp of the oldest key event of a frame to:
+// its pickup in Input::PreUpdate, the end of the simulation tick that used it,
+// and the return of SDL_RenderPresent (closest we can get to the photons)
+struct InputLatencyStats
+{
+	LatencyPercentiles pickup;
+	LatencyPercentiles tick;
+	LatencyPercentiles present;
+	int samples = 0;
+};
+
+// Time spent in one module (PreUpdate + Update + PostUpdate) for every profiled frame
+struct ModuleTimings
+{
+	std::string name;
+	std::vector<float> frameMs;
+};
+
 class Engine
 {
 public:
@@ -30,6 +62,9 @@ public:
 	//	
 	void AddModule(std::shared_ptr<Module> module);
 
+	// --record <file> / --replay <file>, call before Awake
+	void ParseCommandLine(int argc, char* argv[]);
+
 	// Called before render is available
 	bool Awake();
 
@@ -46,9 +81,44 @@ public:
 		return dt;
 	}
 
+	// Step the simulation by a constant dt (ms) instead of the measured frame time, 0 to stop
+	void SetFixedDt(float ms) {
+		fixedDt = ms;
+		if (ms > 0.0f) dt = ms;
+	}
+
+	// Seed of the run (restored from the recording on replay)
+	Uint32 GetRandomSeed() const {
+		return randomSeed;
+	}
+
 	// Draw debug help menu
 	void DrawDebugHelp();
 
+	// Performance overlay (F7), drawn over everything before the present
+	void DrawPerfHud();
+
+	// Percentiles over the last ROLLING_STATS_WINDOW frames that had key events
+	InputLatencyStats GetInputLatencyStats() const;
+
+	// Record the time of each module and of the whole frame (before the frame cap) every frame.
+	// reserveFrames avoids reallocating while profiling
+	void SetModuleProfiling(bool enabled, int reserveFrames = 0);
+	const std::vector<ModuleTimings>& GetModuleTimings() const { return moduleTimings; }
+	const std::vector<float>& GetFrameTimings() const { return frameTimings; }
+
+	// 0 = no frame cap
+	void SetTargetFrameRate(uint32_t fps) { targetFrameRate = fps; }
+
+	// Scratch memory for the current frame, emptied at the end of each Update
+	FrameArena& GetFrameArena() { return frameArena; }
+
+	// Memory of the loaded level, emptied by Map::CleanUp
+	LevelArena& GetLevelArena() { return levelArena; }
+
+	// Memory per subsystem now (see MemoryTracker), e.g. before and after a level load
+	MemorySnapshot GetMemorySnapshot();
+
 	enum EngineState
 	{
 		CREATE = 1,
@@ -89,6 +159,12 @@ private:
 	// Call modules before each loop iteration
 	void FinishUpdate();
 
+	// FPS / frame time / latency in the window title
+	void UpdateTitle();
+
+	// Updates the MemoryTracker tags of the polled subsystems
+	void RefreshMemoryUsage();
+
 	// Call modules before each loop iteration
 	bool PreUpdate();
 
@@ -105,6 +181,13 @@ private:
 
 	// Delta time
 	float dt;
+	float fixedDt = 0.0f;        // ms, > 0 while recording or replaying input
+	float lastFrameMs = 0.0f;    // measured, whatever dt is
+	Uint32 randomSeed = 0;
+
+	// Input recording / replay files
+	std::string recordPath;
+	std::string replayPath;
 
 	// Calculate timing measures
 	Timer startupTime;
@@ -118,6 +201,30 @@ private:
 	float averageFps = 0.0f;
 	float secondsSinceStartup = 0.0f;
 
+	// Input latency stages (ms), see InputLatencyStats
+	RollingStats inputToPickup;
+	RollingStats inputToTick;
+	RollingStats inputToPresent;
+	InputLatencyStats inputLatency;   // refreshed once per second for the title
+
+	FrameArena frameArena;
+	LevelArena levelArena;
+
+	// Previous F8 memory report
+	MemorySnapshot lastMemoryReport;
+	bool hasMemoryReport = false;
+
+	// Module profiling
+	bool profiling = false;
+	bool timingModules = false;          // profiling or the HUD is on, this frame
+	PerfTimer moduleTimer;
+	std::vector<double> frameModuleMs;   // this frame, in moduleList order
+
+	PerfHud perfHud;
+	PerfTimer loopTime;                  // since the first frame, for the average FPS
+	std::vector<ModuleTimings> moduleTimings;
+	std::vector<float> frameTimings;
+
 	// FPS control
 	uint32_t targetFrameRate = 60;
 	uint32_t cappedMs = 1000 / targetFrameRate;
@@ -11,6 +11,7 @@ enum class EntityType
 };
 
 class PhysBody;
+struct Trigger;
 
 class Entity : public std::enable_shared_from_this<Entity>
 {
@@ -70,6 +71,14 @@ public:
 
 	};
 
+	virtual void OnTriggerEnter(Trigger* trigger) {
+
+	};
+
+	virtual void OnTriggerExit(Trigger* trigger) {
+
+	};
+
 public:
 
 	std::string name;
@@ -9,6 +9,7 @@
 EntityManager::EntityManager() : Module()
 {
 	name = "entitymanager";
+	memTag = MemTag::ENTITIES;
 }
 
 // Destructor
@@ -43,9 +44,21 @@ bool EntityManager::Start() {
 		ret = entity->Start();
 	}
 
+	started = true;
 	return ret;
 }
 
+void EntityManager::StartLevelEntities()
+{
+	if (!started) return;
+
+	for (const auto& entity : levelEntities)
+	{
+		if (entity->active == false) continue;
+		entity->Start();
+	}
+}
+
 // Called before quitting
 bool EntityManager::CleanUp()
 {
@@ -58,12 +71,15 @@ bool EntityManager::CleanUp()
 	}
 
 	entities.clear();
+	levelEntities.clear();
+	started = false;
 
 	return ret;
 }
 
 std::shared_ptr<Entity> EntityManager::CreateEntity(EntityType type)
 {
+	MemScope scope(MemTag::ENTITIES);
 	std::shared_ptr<Entity> entity = std::make_shared<Entity>();
 
 	//L04: TODO 3a: Instantiate entity according to the type and add the new entity to the list of Entities
@@ -84,10 +100,48 @@ std::shared_ptr<Entity> EntityManager::CreateEntity(EntityType type)
 	return entity;
 }
 
+std::shared_ptr<Entity> EntityManager::CreateLevelEntity(EntityType type)
+{
+	MemScope scope(MemTag::ENTITIES);
+	LevelArena& arena = Engine::GetInstance().GetLevelArena();
+	std::shared_ptr<Entity> entity;
+
+	switch (type)
+	{
+	case EntityType::PLAYER:
+		entity = std::allocate_shared<Player>(LevelAllocator<Player>(arena));
+		break;
+	case EntityType::ITEM:
+		entity = std::allocate_shared<Item>(LevelAllocator<Item>(arena));
+		break;
+	default:
+		entity = std::allocate_shared<Entity>(LevelAllocator<Entity>(arena));
+		break;
+	}
+
+	entities.push_back(entity);
+	levelEntities.push_back(entity);
+
+	return entity;
+}
+
 void EntityManager::DestroyEntity(std::shared_ptr<Entity> entity)
 {
 	entity->CleanUp();
 	entities.remove(entity);
+	levelEntities.remove(entity);
+}
+
+// The last references of the level entities go here, before the level arena is reset
+void EntityManager::DestroyLevelEntities()
+{
+	for (const auto& entity : levelEntities)
+	{
+		entity->CleanUp();
+		entities.remove(entity);
+	}
+
+	levelEntities.clear();
 }
 
 void EntityManager::AddEntity(std::shared_ptr<Entity> entity)
@@ -98,6 +152,7 @@ void EntityManager::AddEntity(std::shared_ptr<Entity> entity)
 bool EntityManager::Update(float dt)
 {
 	bool ret = true;
+	RenderTagScope renderTag(*Engine::GetInstance().render, RenderTag::ENTITIES);
 	for(const auto entity : entities)
 	{
 		if (entity->active == false) continue;
@@ -28,6 +28,14 @@ public:
 	// Additional methods
 	std::shared_ptr<Entity> CreateEntity(EntityType type);
 
+	// Entity allocated in the level arena, destroyed by DestroyLevelEntities when the level is unloaded
+	std::shared_ptr<Entity> CreateLevelEntity(EntityType type);
+
+	void DestroyLevelEntities();
+
+	// Starts the entities of a level loaded after Start (the first level is started by Start)
+	void StartLevelEntities();
+
 	void DestroyEntity(std::shared_ptr<Entity> entity);
 
 	void AddEntity(std::shared_ptr<Entity> entity);
@@ -36,4 +44,11 @@ public:
 
 	std::list<std::shared_ptr<Entity>> entities;
 
+	// Subset of entities owned by the current level
+	std::list<std::shared_ptr<Entity>> levelEntities;
+
+private:
+
+	bool started = false;
+
 };
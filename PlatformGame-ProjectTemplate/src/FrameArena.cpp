@@ -0,0 +1,75 @@
+#include "FrameArena.h"
+#include "Log.h"
+#include <cstdlib>
+
+FrameArena::~FrameArena()
+{
+	Release();
+}
+
+bool FrameArena::Init(size_t size)
+{
+	Release();
+
+	buffer = static_cast<unsigned char*>(std::malloc(size));
+	if (buffer == nullptr)
+	{
+		LOG("FrameArena: cannot allocate %zu bytes", size);
+		return false;
+	}
+
+	capacity = size;
+	return true;
+}
+
+void FrameArena::Release()
+{
+	Reset();
+	std::free(buffer);
+	buffer = nullptr;
+	capacity = 0;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	// alignment is a power of two
+	size_t start = (offset + alignment - 1) & ~(alignment - 1);
+	if (buffer != nullptr && start + size <= capacity)
+	{
+		offset = start + size;
+		if (offset > highWater)
+			highWater = offset;
+		return buffer + start;
+	}
+
+	// Didn't fit: heap block with a header linking it for Reset
+	size_t header = (sizeof(OverflowBlock) + alignment - 1) & ~(alignment - 1);
+	unsigned char* block = static_cast<unsigned char*>(std::malloc(header + size));
+	if (block == nullptr)
+		return nullptr;
+
+	OverflowBlock* node = reinterpret_cast<OverflowBlock*>(block);
+	node->next = overflow;
+	overflow = node;
+	overflowBytes += size;
+	return block + header;
+}
+
+void FrameArena::Reset()
+{
+	if (overflowBytes > maxOverflowBytes)
+	{
+		maxOverflowBytes = overflowBytes;
+		LOG("FrameArena: %zu bytes didn't fit in the %zu byte arena this frame", overflowBytes, capacity);
+	}
+
+	while (overflow != nullptr)
+	{
+		OverflowBlock* next = overflow->next;
+		std::free(overflow);
+		overflow = next;
+	}
+
+	overflowBytes = 0;
+	offset = 0;
+}
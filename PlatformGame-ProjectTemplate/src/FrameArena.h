@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#define FRAME_ARENA_DEFAULT_SIZE (256 * 1024)
+
+// Linear (bump) allocator for data that only lives during one frame.
+// Allocate moves a pointer, nothing is freed until Reset, which the engine calls in FinishUpdate.
+// When the block is full the allocation falls back to the heap (freed at Reset as well) and is counted,
+// so the size can be tuned from the high-water mark. Game thread only.
+class FrameArena
+{
+public:
+
+	~FrameArena();
+
+	bool Init(size_t capacity);
+	void Release();
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	// Frees everything allocated since the last Reset
+	void Reset();
+
+	size_t GetCapacity() const { return capacity; }
+	size_t GetUsed() const { return offset; }
+	size_t GetHighWater() const { return highWater; }           // most bytes used in one frame
+	size_t GetOverflowBytes() const { return maxOverflowBytes; } // most bytes that didn't fit in one frame
+
+private:
+
+	struct OverflowBlock
+	{
+		OverflowBlock* next;
+	};
+
+	unsigned char* buffer = nullptr;
+	size_t capacity = 0;
+	size_t offset = 0;
+	size_t highWater = 0;
+
+	OverflowBlock* overflow = nullptr;
+	size_t overflowBytes = 0;
+	size_t maxOverflowBytes = 0;
+};
+
+// STL allocator on a FrameArena: deallocate does nothing, the memory comes back at Reset.
+// Containers using it must not outlive the frame.
+template <typename T>
+class FrameAllocator
+{
+public:
+
+	typedef T value_type;
+
+	explicit FrameAllocator(FrameArena& arena) : arena(&arena) {}
+
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	FrameArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) { return a.arena == b.arena; }
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) { return a.arena != b.arena; }
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
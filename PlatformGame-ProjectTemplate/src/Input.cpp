@@ -2,24 +2,49 @@
 #include "Input.h"
 #include "Window.h"
 #include "Log.h"
+#include <string>
 
-#define MAX_KEYS 300
+// Config names of the actions, in InputAction order
+static const char* actionNames[(int)InputAction::COUNT] = { "left", "right", "up", "down", "jump", "dash" };
 
 Input::Input() : Module()
 {
 	name = "input";
 
 	keyboard = new KeyState[MAX_KEYS];
+	keyHeld = new bool[MAX_KEYS];
+	keyChanged = new bool[MAX_KEYS];
+	releasePending = new bool[MAX_KEYS];
 	memset(keyboard, KEY_IDLE, sizeof(KeyState) * MAX_KEYS);
+	memset(keyHeld, 0, sizeof(bool) * MAX_KEYS);
+	memset(keyChanged, 0, sizeof(bool) * MAX_KEYS);
+	memset(releasePending, 0, sizeof(bool) * MAX_KEYS);
 	memset(mouseButtons, KEY_IDLE, sizeof(KeyState) * NUM_MOUSE_BUTTONS);
 	memset(windowEvents, 0, sizeof(windowEvents));
 	mouseMotionX = mouseMotionY = mouseX = mouseY = 0;
+
+	// Default bindings, overridden by config.xml
+	const SDL_Scancode left[] = { SDL_SCANCODE_A };
+	const SDL_Scancode right[] = { SDL_SCANCODE_D };
+	const SDL_Scancode up[] = { SDL_SCANCODE_W };
+	const SDL_Scancode down[] = { SDL_SCANCODE_S };
+	const SDL_Scancode jump[] = { SDL_SCANCODE_SPACE };
+	const SDL_Scancode dash[] = { SDL_SCANCODE_LSHIFT, SDL_SCANCODE_RSHIFT };
+	BindAction(InputAction::LEFT, left, 1);
+	BindAction(InputAction::RIGHT, right, 1);
+	BindAction(InputAction::UP, up, 1);
+	BindAction(InputAction::DOWN, down, 1);
+	BindAction(InputAction::JUMP, jump, 1);
+	BindAction(InputAction::DASH, dash, 2);
 }
 
 // Destructor
 Input::~Input()
 {
 	delete[] keyboard;
+	delete[] keyHeld;
+	delete[] keyChanged;
+	delete[] releasePending;
 }
 
 // Called before render is available
@@ -34,6 +59,9 @@ bool Input::Awake()
 		ret = false;
 	}
 
+	LoadBindings();
+	frameEnd = SDL_GetTicksNS();
+
 	return ret;
 }
 
@@ -49,27 +77,32 @@ bool Input::PreUpdate()
 {
 	static SDL_Event event;
 
-	int numKeys = 0;
-	const bool* keys = SDL_GetKeyboardState(&numKeys);
-
-	for (int i = 0; i < MAX_KEYS; ++i)
+	// Only the keys that changed last frame move on: DOWN -> REPEAT, UP -> IDLE
+	int lastCount = changedCount;
+	changedCount = 0;
+	for (int i = 0; i < lastCount; ++i)
 	{
-		if (keys[i] == 1)
-		{
-			if (keyboard[i] == KEY_IDLE)
-				keyboard[i] = KEY_DOWN;
-			else
-				keyboard[i] = KEY_REPEAT;
-		}
-		else
+		int key = changedKeys[i];
+		keyChanged[key] = false;
+	}
+	for (int i = 0; i < lastCount; ++i)
+	{
+		int key = changedKeys[i];
+		if (releasePending[key])
 		{
-			if (keyboard[i] == KEY_REPEAT || keyboard[i] == KEY_DOWN)
-				keyboard[i] = KEY_UP;
-			else
-				keyboard[i] = KEY_IDLE;
+			releasePending[key] = false;
+			keyboard[key] = KEY_UP;
+			MarkChanged(key);
 		}
+		else if (keyboard[key] == KEY_DOWN)
+			keyboard[key] = KEY_REPEAT;
+		else if (keyboard[key] == KEY_UP)
+			keyboard[key] = KEY_IDLE;
 	}
 
+	eventCount = 0;
+	frameStart = frameEnd;
+
 	for (int i = 0; i < NUM_MOUSE_BUTTONS; ++i)
 	{
 		if (mouseButtons[i] == KEY_DOWN)
@@ -91,6 +124,9 @@ bool Input::PreUpdate()
 		case SDL_EVENT_WINDOW_MINIMIZED:
 		case SDL_EVENT_WINDOW_FOCUS_LOST:
 			windowEvents[WE_HIDE] = true;
+			// The key ups won't reach us anymore
+			if (!IsReplaying())
+				ReleaseAllKeys(event.common.timestamp);
 			break;
 
 		case SDL_EVENT_WINDOW_SHOWN:
@@ -100,6 +136,13 @@ bool Input::PreUpdate()
 			windowEvents[WE_SHOW] = true;
 			break;
 
+		case SDL_EVENT_KEY_DOWN:
+		case SDL_EVENT_KEY_UP:
+			// OS auto-repeat is not a new press. A replay ignores the keyboard
+			if (!event.key.repeat && !IsReplaying())
+				OnKey(event.key.scancode, event.key.down, event.key.timestamp);
+			break;
+
 		case SDL_EVENT_MOUSE_BUTTON_DOWN:
 			if (event.button.button >= 1 && event.button.button <= NUM_MOUSE_BUTTONS)
 				mouseButtons[event.button.button - 1] = KEY_DOWN;
@@ -122,12 +165,192 @@ bool Input::PreUpdate()
 		}
 	}
 
+	frameEnd = SDL_GetTicksNS();
+
+	if (IsReplaying())
+	{
+		RecordedKey keys[MAX_INPUT_EVENTS];
+		int count = playback.ReadTick(tick, keys, MAX_INPUT_EVENTS);
+		for (int i = 0; i < count; ++i)
+			OnKey(keys[i].scancode, keys[i].down, frameEnd);
+
+		if (playback.Finished(tick) && !windowEvents[WE_QUIT])
+		{
+			LOG("Input: replay finished after %u ticks", tick + 1);
+			windowEvents[WE_QUIT] = true;
+		}
+	}
+
+	ResolveActions();
+
+	recorder.EndTick(tick);
+	++tick;
+
 	return true;
 }
 
+bool Input::StartRecording(const char* path, const InputRecordingHeader& header)
+{
+	return recorder.Open(path, header);
+}
+
+bool Input::StartReplay(const char* path)
+{
+	return playback.Open(path);
+}
+
+void Input::OnKey(SDL_Scancode key, bool down, Uint64 timestamp)
+{
+	if (key <= SDL_SCANCODE_UNKNOWN || key >= MAX_KEYS || keyHeld[key] == down)
+		return;
+
+	keyHeld[key] = down;
+	recorder.AddKey(key, down);
+
+	if (down)
+	{
+		keyboard[key] = KEY_DOWN;
+		releasePending[key] = false;
+	}
+	else if (keyboard[key] == KEY_DOWN && keyChanged[key])
+	{
+		// Pressed this frame: report the press now and the release next frame
+		releasePending[key] = true;
+	}
+	else
+	{
+		keyboard[key] = KEY_UP;
+	}
+	MarkChanged(key);
+
+	if (eventCount < MAX_INPUT_EVENTS)
+		events[eventCount++] = { timestamp, key, down };
+}
+
+void Input::MarkChanged(int key)
+{
+	if (keyChanged[key])
+		return;
+
+	keyChanged[key] = true;
+	changedKeys[changedCount++] = key;
+}
+
+void Input::ReleaseAllKeys(Uint64 timestamp)
+{
+	for (int i = 0; i < MAX_KEYS; ++i)
+	{
+		if (keyHeld[i])
+			OnKey((SDL_Scancode)i, false, timestamp);
+	}
+}
+
+void Input::ResolveActions()
+{
+	for (int a = 0; a < (int)InputAction::COUNT; ++a)
+	{
+		ActionState& action = actions[a];
+		action = ActionState();
+
+		bool down = false, held = false, up = false;
+		for (int b = 0; b < bindingCount[a]; ++b)
+		{
+			KeyState state = keyboard[bindings[a][b]];
+			down |= state == KEY_DOWN;
+			held |= state == KEY_REPEAT;
+			up |= state == KEY_UP;
+		}
+
+		if (down)
+			action.state = KEY_DOWN;
+		else if (held)
+			action.state = KEY_REPEAT;
+		else if (up)
+			action.state = KEY_UP;
+
+		// Timestamps from this frame's events
+		if (!down && !up)
+			continue;
+
+		for (int e = 0; e < eventCount; ++e)
+		{
+			for (int b = 0; b < bindingCount[a]; ++b)
+			{
+				if (events[e].scancode != bindings[a][b])
+					continue;
+
+				if (events[e].down)
+				{
+					if (action.presses == 0)
+						action.pressTime = events[e].timestamp;
+					++action.presses;
+				}
+				else
+				{
+					action.releaseTime = events[e].timestamp;
+				}
+			}
+		}
+	}
+}
+
+void Input::BindAction(InputAction action, const SDL_Scancode* keys, int count)
+{
+	int a = (int)action;
+	bindingCount[a] = 0;
+	for (int i = 0; i < count && bindingCount[a] < MAX_ACTION_BINDINGS; ++i)
+	{
+		if (keys[i] > SDL_SCANCODE_UNKNOWN && keys[i] < MAX_KEYS)
+			bindings[a][bindingCount[a]++] = keys[i];
+	}
+}
+
+// <action name="dash" keys="Left Shift,Right Shift"/>, key names as in SDL_GetScancodeFromName
+void Input::LoadBindings()
+{
+	for (pugi::xml_node node = configParameters.child("action"); node; node = node.next_sibling("action"))
+	{
+		int a = 0;
+		while (a < (int)InputAction::COUNT && strcmp(actionNames[a], node.attribute("name").as_string()) != 0)
+			++a;
+
+		if (a == (int)InputAction::COUNT)
+		{
+			LOG("Input: unknown action %s", node.attribute("name").as_string());
+			continue;
+		}
+
+		SDL_Scancode keys[MAX_ACTION_BINDINGS];
+		int count = 0;
+		std::string list = node.attribute("keys").as_string();
+		size_t start = 0;
+		while (start <= list.size() && count < MAX_ACTION_BINDINGS)
+		{
+			size_t end = list.find(',', start);
+			if (end == std::string::npos)
+				end = list.size();
+
+			std::string keyName = list.substr(start, end - start);
+			SDL_Scancode key = SDL_GetScancodeFromName(keyName.c_str());
+			if (key == SDL_SCANCODE_UNKNOWN)
+				LOG("Input: unknown key '%s' for action %s", keyName.c_str(), actionNames[a]);
+			else
+				keys[count++] = key;
+
+			start = end + 1;
+		}
+
+		if (count > 0)
+			BindAction((InputAction)a, keys, count);
+	}
+}
+
 // Called before quitting
 bool Input::CleanUp()
 {
+	// 'tick' was already advanced past the last processed one
+	recorder.Close(tick > 0 ? tick - 1 : 0);
+
 	LOG("Quitting SDL event subsystem");
 	SDL_QuitSubSystem(SDL_INIT_EVENTS);
 	return true;
@@ -3,8 +3,12 @@
 #include "Module.h"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_rect.h>
+#include "InputRecording.h"
 
 #define NUM_MOUSE_BUTTONS 5
+#define MAX_KEYS SDL_SCANCODE_COUNT
+#define MAX_INPUT_EVENTS 64        // key events kept per frame
+#define MAX_ACTION_BINDINGS 4      // keys per action
 
 enum EventWindow
 {
@@ -22,6 +26,35 @@ enum KeyState
 	KEY_UP
 };
 
+// Gameplay actions, bound to keys in config.xml (<input><action name="jump" keys="Space"/>)
+enum class InputAction
+{
+	LEFT = 0,
+	RIGHT,
+	UP,
+	DOWN,
+	JUMP,
+	DASH,
+	COUNT
+};
+
+// Key press or release with the SDL timestamp of the event (ns, SDL_GetTicksNS clock)
+struct InputEvent
+{
+	Uint64 timestamp;
+	SDL_Scancode scancode;
+	bool down;
+};
+
+// Action resolved once per frame from its bound keys
+struct ActionState
+{
+	KeyState state = KEY_IDLE;
+	int presses = 0;           // presses this frame, a press and release inside one frame still counts
+	Uint64 pressTime = 0;      // first press of this frame
+	Uint64 releaseTime = 0;    // last release of this frame
+};
+
 class Input : public Module
 {
 
@@ -50,6 +83,42 @@ public:
 		return keyboard[id];
 	}
 
+	const ActionState& GetAction(InputAction action) const
+	{
+		return actions[(int)action];
+	}
+
+	// Keys whose state changed this frame (DOWN or UP)
+	const int* GetChangedKeys(int& count) const
+	{
+		count = changedCount;
+		return changedKeys;
+	}
+
+	// Key events of this frame in arrival order. They happened between
+	// GetFrameStart and GetFrameEnd, which lets a fixed step apply them at their own time
+	const InputEvent* GetEvents(int& count) const
+	{
+		count = eventCount;
+		return events;
+	}
+
+	Uint64 GetFrameStart() const { return frameStart; }
+	Uint64 GetFrameEnd() const { return frameEnd; }
+
+	// Replace the keys of an action (up to MAX_ACTION_BINDINGS)
+	void BindAction(InputAction action, const SDL_Scancode* keys, int count);
+
+	// Record the key events of every tick, or play a recording back instead of the keyboard.
+	// Call before Awake, the engine must run at the recording's fixed dt
+	bool StartRecording(const char* path, const InputRecordingHeader& header);
+	bool StartReplay(const char* path);
+	bool IsReplaying() const { return playback.IsOpen(); }
+	const InputRecordingHeader& GetReplayHeader() const { return playback.GetHeader(); }
+
+	// Ticks (PreUpdate calls) since the start
+	Uint32 GetTick() const { return tick; }
+
 	KeyState GetMouseButtonDown(int id) const
 	{
 		return mouseButtons[id - 1];
@@ -63,8 +132,33 @@ public:
 	void GetMouseMotion(int& x, int& y);
 
 private:
+	void OnKey(SDL_Scancode key, bool down, Uint64 timestamp);
+	void MarkChanged(int key);
+	void ReleaseAllKeys(Uint64 timestamp);
+	void ResolveActions();
+	void LoadBindings();
+
 	bool windowEvents[WE_COUNT];
 	KeyState* keyboard;
+	bool* keyHeld;                         // physical state from the events
+	bool* keyChanged;                      // already in changedKeys
+	bool* releasePending;                  // pressed and released in the same frame, KEY_UP next frame
+	int changedKeys[MAX_KEYS];
+	int changedCount = 0;
+
+	InputEvent events[MAX_INPUT_EVENTS];
+	int eventCount = 0;
+	Uint64 frameStart = 0;
+	Uint64 frameEnd = 0;
+
+	Uint32 tick = 0;
+	InputRecorder recorder;
+	InputPlayback playback;
+
+	SDL_Scancode bindings[(int)InputAction::COUNT][MAX_ACTION_BINDINGS];
+	int bindingCount[(int)InputAction::COUNT];
+	ActionState actions[(int)InputAction::COUNT];
+
 	KeyState mouseButtons[NUM_MOUSE_BUTTONS];
 	int	mouseMotionX;
 	int mouseMotionY;
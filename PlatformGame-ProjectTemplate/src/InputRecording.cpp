@@ -0,0 +1,181 @@
+#include "InputRecording.h"
+#include "Log.h"
+
+#define INPUT_RECORDING_MAGIC "PGIR"
+#define INPUT_RECORDING_VERSION 1
+
+InputRecorder::~InputRecorder()
+{
+	if (file)
+		SDL_CloseIO(file);
+}
+
+bool InputRecorder::Open(const char* path, const InputRecordingHeader& header)
+{
+	file = SDL_IOFromFile(path, "wb");
+	if (!file)
+	{
+		LOG("InputRecorder: cannot create %s: %s", path, SDL_GetError());
+		return false;
+	}
+
+	buffer.clear();
+	buffer.insert(buffer.end(), INPUT_RECORDING_MAGIC, INPUT_RECORDING_MAGIC + 4);
+	buffer.push_back(INPUT_RECORDING_VERSION);
+	WriteVarint(header.seed);
+
+	Uint32 dtBits;
+	SDL_memcpy(&dtBits, &header.fixedDt, sizeof(dtBits));
+	WriteVarint(dtBits);
+	WriteVarint((Uint32)header.level);
+
+	WriteVarint((Uint32)header.config.size());
+	buffer.insert(buffer.end(), header.config.begin(), header.config.end());
+	Flush();
+
+	lastRecordTick = 0;
+	LOG("InputRecorder: recording to %s (seed %u, dt %.3f ms)", path, header.seed, header.fixedDt);
+	return true;
+}
+
+void InputRecorder::Close(Uint32 lastTick)
+{
+	if (!file)
+		return;
+
+	// End marker
+	WriteVarint(lastTick - lastRecordTick);
+	WriteVarint(0);
+	Flush();
+
+	SDL_CloseIO(file);
+	file = nullptr;
+	LOG("InputRecorder: %u ticks recorded", lastTick + 1);
+}
+
+void InputRecorder::AddKey(SDL_Scancode scancode, bool down)
+{
+	if (file)
+		tickKeys.push_back(((Uint32)scancode << 1) | (down ? 1 : 0));
+}
+
+void InputRecorder::EndTick(Uint32 tick)
+{
+	if (!file || tickKeys.empty())
+		return;
+
+	// Ticks without events cost nothing
+	WriteVarint(tick - lastRecordTick);
+	WriteVarint((Uint32)tickKeys.size());
+	for (Uint32 key : tickKeys)
+		WriteVarint(key);
+
+	lastRecordTick = tick;
+	tickKeys.clear();
+	Flush();
+}
+
+void InputRecorder::WriteVarint(Uint32 value)
+{
+	while (value >= 0x80)
+	{
+		buffer.push_back((Uint8)(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back((Uint8)value);
+}
+
+void InputRecorder::Flush()
+{
+	if (!buffer.empty() && SDL_WriteIO(file, buffer.data(), buffer.size()) != buffer.size())
+		LOG("InputRecorder: write failed: %s", SDL_GetError());
+	buffer.clear();
+}
+
+bool InputPlayback::Open(const char* path)
+{
+	size_t size = 0;
+	void* contents = SDL_LoadFile(path, &size);
+	if (!contents)
+	{
+		LOG("InputPlayback: cannot read %s: %s", path, SDL_GetError());
+		return false;
+	}
+	data.assign((Uint8*)contents, (Uint8*)contents + size);
+	SDL_free(contents);
+
+	Uint32 dtBits = 0, level = 0, configSize = 0;
+	bool ok = size > 5 && SDL_memcmp(data.data(), INPUT_RECORDING_MAGIC, 4) == 0 && data[4] == INPUT_RECORDING_VERSION;
+	cursor = 5;
+	ok = ok && ReadVarint(header.seed) && ReadVarint(dtBits) && ReadVarint(level) && ReadVarint(configSize);
+	ok = ok && cursor + configSize <= data.size();
+	if (!ok)
+	{
+		LOG("InputPlayback: %s is not an input recording (version %d)", path, INPUT_RECORDING_VERSION);
+		data.clear();
+		return false;
+	}
+
+	SDL_memcpy(&header.fixedDt, &dtBits, sizeof(dtBits));
+	header.level = (int)level;
+	header.config.assign((const char*)data.data() + cursor, configSize);
+	cursor += configSize;
+
+	nextTick = 0;
+	ended = false;
+	ReadNextRecord();
+
+	LOG("InputPlayback: replaying %s (seed %u, dt %.3f ms, level %d)", path, header.seed, header.fixedDt, header.level);
+	return true;
+}
+
+int InputPlayback::ReadTick(Uint32 tick, RecordedKey* out, int maxKeys)
+{
+	if (ended || tick != nextTick)
+		return 0;
+
+	int count = 0;
+	for (Uint32 i = 0; i < nextCount; ++i)
+	{
+		Uint32 key = 0;
+		if (!ReadVarint(key))
+			break;
+		if (count < maxKeys)
+			out[count++] = { (SDL_Scancode)(key >> 1), (key & 1) != 0 };
+	}
+
+	ReadNextRecord();
+	return count;
+}
+
+void InputPlayback::ReadNextRecord()
+{
+	Uint32 delta = 0;
+	if (!ReadVarint(delta) || !ReadVarint(nextCount))
+	{
+		// Truncated file: stop at the last complete record
+		ended = true;
+		endTick = nextTick;
+		return;
+	}
+
+	nextTick += delta;
+	if (nextCount == 0)
+	{
+		ended = true;
+		endTick = nextTick;
+	}
+}
+
+bool InputPlayback::ReadVarint(Uint32& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35 && cursor < data.size(); shift += 7)
+	{
+		Uint8 byte = data[cursor++];
+		value |= (Uint32)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+
+// Everything a run depends on besides the input
+struct InputRecordingHeader
+{
+	Uint32 seed = 0;
+	float fixedDt = 0.0f;     // ms per tick
+	int level = 1;            // level loaded by Scene::Start
+	std::string config;       // config.xml contents
+};
+
+// Key event of a recorded tick
+struct RecordedKey
+{
+	SDL_Scancode scancode;
+	bool down;
+};
+
+// Input recording file:
+//   "PGIR", version, seed, fixed dt, level, config (length + text)
+//   then one record per tick with key events: ticks since the previous record,
+//   event count, and (scancode << 1 | down) for each event, all as varints.
+//   A record with 0 events marks the last tick of the run.
+class InputRecorder
+{
+public:
+
+	~InputRecorder();
+
+	bool Open(const char* path, const InputRecordingHeader& header);
+	// lastTick: the last tick that was processed, the replay stops after it
+	void Close(Uint32 lastTick);
+	bool IsOpen() const { return file != nullptr; }
+
+	// Buffer one event of the current tick, then flush them all in EndTick
+	void AddKey(SDL_Scancode scancode, bool down);
+	void EndTick(Uint32 tick);
+
+private:
+
+	void WriteVarint(Uint32 value);
+	void Flush();
+
+	SDL_IOStream* file = nullptr;
+	std::vector<Uint8> buffer;
+	std::vector<Uint32> tickKeys;     // encoded events of the current tick
+	Uint32 lastRecordTick = 0;
+};
+
+// Loads a whole recording in memory, then hands its events back tick by tick
+class InputPlayback
+{
+public:
+
+	bool Open(const char* path);
+	bool IsOpen() const { return !data.empty(); }
+
+	const InputRecordingHeader& GetHeader() const { return header; }
+
+	// Events of 'tick' (ticks must be asked in order), returns the count written to 'out'
+	int ReadTick(Uint32 tick, RecordedKey* out, int maxKeys);
+
+	// 'tick' is the last tick of the recorded run
+	bool Finished(Uint32 tick) const { return ended && tick >= endTick; }
+
+private:
+
+	bool ReadVarint(Uint32& value);
+	void ReadNextRecord();
+
+	std::vector<Uint8> data;
+	size_t cursor = 0;
+	InputRecordingHeader header;
+
+	Uint32 nextTick = 0;       // tick of the next record
+	Uint32 nextCount = 0;
+	bool ended = false;
+	Uint32 endTick = 0;
+};
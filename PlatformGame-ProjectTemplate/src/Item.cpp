@@ -6,8 +6,8 @@
 #include "Render.h"
 #include "Scene.h"
 #include "Log.h"
-#include "Physics.h"
 #include "EntityManager.h"
+#include "Map.h"
 
 Item::Item() : Entity(EntityType::ITEM)
 {
@@ -23,17 +23,13 @@ bool Item::Awake() {
 bool Item::Start() {
 
 	//initilize textures
-	texture = Engine::GetInstance().textures->Load("Assets/Textures/goldCoin.png");
+	sprite = Engine::GetInstance().textures->LoadRegion("Assets/Textures/goldCoin.png", AtlasGroup::COMMON);
 	
-	// L08 TODO 4: Add a physics to an item - initialize the physics body
-	Engine::GetInstance().textures.get()->GetSize(texture, texW, texH);
-	pbody = Engine::GetInstance().physics->CreateCircle((int)position.getX() + texH / 2, (int)position.getY() + texH / 2, texH / 2, bodyType::STATIC);
-
-	// L08 TODO 7: Assign collider type
-	pbody->ctype = ColliderType::ITEM;
-
-	// Set this class as the listener of the pbody
-	pbody->listener = this;   // so Begin/EndContact can call back to Item
+	// Coins are picked through the trigger system instead of a static Box2D body
+	texW = sprite.rect.w;
+	texH = sprite.rect.h;
+	SDL_FRect bounds = { position.getX(), position.getY(), (float)texW, (float)texH };
+	triggerId = Engine::GetInstance().map->triggers.AddTrigger(TriggerType::COIN, bounds, name, this);
 
 	return true;
 }
@@ -42,21 +38,21 @@ bool Item::Update(float dt)
 {
 	if (!active) return true;
 
-	// L08 TODO 4: Add a physics to an item - update the position of the object from the physics.  
-	int x, y;
-	pbody->GetPosition(x, y);
-	position.setX((float)x);
-	position.setY((float)y);
-
-	Engine::GetInstance().render->DrawTexture(texture, x - texW / 2, y - texH / 2);
+	Engine::GetInstance().render->DrawTexture(sprite.texture, (int)position.getX(), (int)position.getY(), &sprite.rect);
 
 	return true;
 }
 
 bool Item::CleanUp()
 {
-	Engine::GetInstance().textures->UnLoad(texture);
-	Engine::GetInstance().physics->DeletePhysBody(pbody);
+	// The sprite stays in the common atlas for the next coins
+
+	// Only disable the trigger if it is still ours (the map may have been reloaded)
+	Trigger* trigger = Engine::GetInstance().map->triggers.GetTrigger(triggerId);
+	if (trigger != nullptr && trigger->listener == this) {
+		Engine::GetInstance().map->triggers.RemoveTrigger(triggerId);
+	}
+	triggerId = -1;
 	return true;
 }
 
@@ -1,10 +1,9 @@
 #pragma once
 
 #include "Entity.h"
+#include "TextureAtlas.h"
 #include <SDL3/SDL.h>
 
-struct SDL_Texture;
-
 class Item : public Entity
 {
 public:
@@ -28,10 +27,10 @@ public:
 
 private:
 
-	SDL_Texture* texture;
+	TextureRegion sprite;   // shared by all the coins, in the common atlas
 	const char* texturePath;
 	int texW, texH;
 
-	//L08 TODO 4: Add a physics to an item
-	PhysBody* pbody;
+	// Pickup volume in the map trigger system (no physics body)
+	int triggerId = -1;
 };
@@ -0,0 +1,139 @@
+#include "LevelArena.h"
+#include "Log.h"
+#include <cstdlib>
+#include <cstring>
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+	// alignment is a power of two
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LevelArena::~LevelArena()
+{
+	Release();
+}
+
+bool LevelArena::Init(size_t size)
+{
+	Release();
+
+	blockSize = size > 0 ? size : LEVEL_ARENA_BLOCK_SIZE;
+	if (AddBlock(blockSize) == nullptr)
+	{
+		LOG("LevelArena: cannot allocate %zu bytes", blockSize);
+		return false;
+	}
+	return true;
+}
+
+void LevelArena::Release()
+{
+	Reset();
+
+	while (first != nullptr)
+	{
+		Block* next = first->next;
+		std::free(first);
+		first = next;
+	}
+
+	current = nullptr;
+	reserved = 0;
+}
+
+LevelArena::Block* LevelArena::AddBlock(size_t minSize)
+{
+	size_t size = minSize > blockSize ? minSize : blockSize;
+	Block* block = static_cast<Block*>(std::malloc(AlignUp(sizeof(Block), alignof(std::max_align_t)) + size));
+	if (block == nullptr)
+		return nullptr;
+
+	block->next = nullptr;
+	block->size = size;
+	block->offset = 0;
+	reserved += size;
+
+	// Appended at the end of the chain, after the blocks in use
+	if (first == nullptr)
+	{
+		first = block;
+	}
+	else
+	{
+		Block* last = current != nullptr ? current : first;
+		while (last->next != nullptr)
+			last = last->next;
+		last->next = block;
+	}
+	return block;
+}
+
+void* LevelArena::Allocate(size_t size, size_t alignment)
+{
+	if (current == nullptr)
+		current = first;
+
+	// Blocks after the current one are left from a previous level and are empty
+	while (current != nullptr)
+	{
+		size_t start = AlignUp(current->offset, alignment);
+		if (start + size <= current->size)
+		{
+			unsigned char* data = reinterpret_cast<unsigned char*>(current) + AlignUp(sizeof(Block), alignof(std::max_align_t));
+			used += start + size - current->offset;
+			current->offset = start + size;
+			if (used > highWater)
+				highWater = used;
+			return data + start;
+		}
+
+		if (current->next == nullptr)
+			break;
+		current = current->next;
+	}
+
+	Block* block = AddBlock(size + alignment);
+	if (block == nullptr)
+		return nullptr;
+
+	current = block;
+	return Allocate(size, alignment);
+}
+
+const char* LevelArena::NewString(const char* text)
+{
+	size_t length = strlen(text);
+	char* copy = static_cast<char*>(Allocate(length + 1, 1));
+	if (copy == nullptr)
+		return "";
+
+	memcpy(copy, text, length + 1);
+	return copy;
+}
+
+void LevelArena::AddFinalizer(void* object, void (*destroy)(void*))
+{
+	Finalizer* finalizer = static_cast<Finalizer*>(Allocate(sizeof(Finalizer), alignof(Finalizer)));
+	finalizer->destroy = destroy;
+	finalizer->object = object;
+	finalizer->next = finalizers;
+	finalizers = finalizer;
+}
+
+void LevelArena::Reset()
+{
+	// Newest first, like the stack unwinding of a scope
+	while (finalizers != nullptr)
+	{
+		Finalizer* finalizer = finalizers;
+		finalizers = finalizer->next;
+		finalizer->destroy(finalizer->object);
+	}
+
+	for (Block* block = first; block != nullptr; block = block->next)
+		block->offset = 0;
+
+	current = first;
+	used = 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#define LEVEL_ARENA_BLOCK_SIZE (64 * 1024)
+
+// Memory for everything that lives as long as a level (map data, colliders, level entities).
+// Allocations are bumped out of blocks that are kept across levels, Reset releases the whole level
+// at once: it runs the destructors registered by New (newest first) and rewinds the blocks.
+// Objects built only from arena memory (NewString, NewArray, trivially destructible types)
+// register no destructor, so releasing them costs nothing per object. Game thread only.
+class LevelArena
+{
+public:
+
+	~LevelArena();
+
+	// Reserves the first block, more blocks are added when it is full
+	bool Init(size_t blockSize);
+	void Release();
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	// Constructs a T in the arena, its destructor runs at Reset
+	template <typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		void* memory = Allocate(sizeof(T), alignof(T));
+		if (memory == nullptr)
+			return nullptr;
+
+		T* object = new (memory) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value)
+			AddFinalizer(object, [](void* p) { static_cast<T*>(p)->~T(); });
+		return object;
+	}
+
+	// Copy of a C string in the arena
+	const char* NewString(const char* text);
+
+	// 'count' value-initialized Ts. Only for trivially destructible types: nothing runs at Reset
+	template <typename T>
+	T* NewArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "NewArray registers no destructor");
+		T* array = static_cast<T*>(Allocate(sizeof(T) * (count > 0 ? count : 1), alignof(T)));
+		if (array == nullptr)
+			return nullptr;
+
+		for (size_t i = 0; i < count; ++i)
+			new (array + i) T();
+		return array;
+	}
+
+	// Ends the level: every pointer taken from the arena is invalid after this
+	void Reset();
+
+	size_t GetUsed() const { return used; }
+	size_t GetReserved() const { return reserved; }   // bytes held in blocks
+	size_t GetHighWater() const { return highWater; } // most bytes used by one level
+
+private:
+
+	struct Block
+	{
+		Block* next;
+		size_t size;
+		size_t offset;
+	};
+
+	struct Finalizer
+	{
+		void (*destroy)(void*);
+		void* object;
+		Finalizer* next;
+	};
+
+	void AddFinalizer(void* object, void (*destroy)(void*));
+	Block* AddBlock(size_t minSize);
+
+	Block* first = nullptr;
+	Block* current = nullptr;
+	Finalizer* finalizers = nullptr;
+
+	size_t blockSize = LEVEL_ARENA_BLOCK_SIZE;
+	size_t used = 0;
+	size_t reserved = 0;
+	size_t highWater = 0;
+};
+
+// STL allocator on a LevelArena (e.g. std::allocate_shared for level entities).
+// deallocate does nothing, the memory comes back at Reset
+template <typename T>
+class LevelAllocator
+{
+public:
+
+	typedef T value_type;
+
+	explicit LevelAllocator(LevelArena& arena) : arena(&arena) {}
+
+	template <typename U>
+	LevelAllocator(const LevelAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count)
+	{
+		T* memory = static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+		if (memory == nullptr)
+			throw std::bad_alloc();
+		return memory;
+	}
+
+	void deallocate(T*, size_t) {}
+
+	LevelArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const LevelAllocator<T>& a, const LevelAllocator<U>& b) { return a.arena == b.arena; }
+
+template <typename T, typename U>
+bool operator!=(const LevelAllocator<T>& a, const LevelAllocator<U>& b) { return a.arena != b.arena; }
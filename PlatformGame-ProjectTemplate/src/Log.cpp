@@ -2,22 +2,18 @@
 #include <iostream>
 #include <cstdarg>
 #include <cstdio>
-#include <string>
 
 void Log(const char file[], int line, const char* format, ...)
 {
-    static char tmpString1[4096];
-    static va_list ap;
+    // On the stack: Log is also called from the loader and audio threads
+    char message[4096];
+    va_list ap;
 
     // Construct the string from variable arguments
     va_start(ap, format);
-    vsnprintf(tmpString1, 4096, format, ap);
+    vsnprintf(message, sizeof(message), format, ap);
     va_end(ap);
 
-    // Construct the final log message
-    std::string logMessage = std::string("\n") + file + "(" + std::to_string(line) + ") : " + tmpString1;
-
-    // Print the formatted string to the standard error stream
-    std::cerr << logMessage << std::endl;
+    // Print the final log message to the standard error stream, no temporary strings
+    std::cerr << '\n' << file << '(' << line << ") : " << message << std::endl;
 }
-
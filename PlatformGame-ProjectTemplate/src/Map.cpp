@@ -12,6 +12,7 @@
 Map::Map() : Module(), mapLoaded(false)
 {
     name = "map";
+    memTag = MemTag::MAP;
 }
 
 // Destructor
@@ -38,6 +39,7 @@ bool Map::Update(float dt)
     bool ret = true;
 
     if (mapLoaded) {
+        RenderTagScope renderTag(*Engine::GetInstance().render, RenderTag::MAP);
 
         for (const auto& imageLayer : mapData.imageLayers) {
             if (imageLayer->texture) {
@@ -83,6 +85,11 @@ bool Map::Update(float dt)
                 }
             }
         }
+
+        if (Engine::GetInstance().physics->debug) {
+            RenderTagScope debugTag(*Engine::GetInstance().render, RenderTag::DEBUG);
+            triggers.DebugDraw();
+        }
     }
 
     return ret;
@@ -106,31 +113,41 @@ bool Map::CleanUp()
 {
     LOG("Unloading map");
 
-    // L06: TODO 2: Make sure you clean up any memory allocated from tilesets/map
-    for (const auto& tileset : mapData.tilesets) {
-        delete tileset;
-    }
-    mapData.tilesets.clear();
+    // Coins first: they remove their triggers in CleanUp
+    Engine::GetInstance().entityManager->DestroyLevelEntities();
 
-    // L07 TODO 2: clean up all layer data
-    for (const auto& layer : mapData.layers)
-    {
-        delete layer;
+    for (PhysBody* collider : mapData.colliders) {
+        Engine::GetInstance().physics->DestroyPhysBodyNow(collider);
     }
-    mapData.layers.clear();
+    mapData.colliders.clear();
 
-    for (const auto& imageLayer : mapData.imageLayers)
-    {
-        delete imageLayer;
+    Engine::GetInstance().textures->ReleaseAtlas(AtlasGroup::LEVEL);
+
+    // Backgrounds are not in the atlas, each one has its own texture
+    for (ImageLayer* imageLayer : mapData.imageLayers) {
+        if (imageLayer->texture) {
+            Engine::GetInstance().textures->UnLoad(imageLayer->texture);
+            imageLayer->texture = nullptr;
+        }
     }
+
+    // L06: TODO 2: Make sure you clean up any memory allocated from tilesets/map
+    // L07 TODO 2: clean up all layer data
+    // Tilesets, layers, properties and checkpoints live in the level arena, released below
+    mapData.tilesets.clear();
+    mapData.layers.clear();
     mapData.imageLayers.clear();
+    mapData.checkpoints.clear();
 
+    triggers.Clear();
 
-    for (const auto& checkpoint : mapData.checkpoints)
-    {
-        delete checkpoint;
+    for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+        mapData.tileClasses[c].Clear();
     }
-    mapData.checkpoints.clear();
+
+    Engine::GetInstance().GetLevelArena().Reset();
+    mapLoaded = false;
+    MemoryTracker::Set(MemTag::MAP, 0, 0);
 
     return true;
 }
@@ -145,6 +162,9 @@ bool Map::Load(std::string path, std::string fileName)
     mapPath = path;
     std::string mapPathName = mapPath + mapFileName;
 
+    MemScope scope(MemTag::MAP);
+    LevelArena& arena = Engine::GetInstance().GetLevelArena();
+
     pugi::xml_document mapFileXML;
     pugi::xml_parse_result result = mapFileXML.load_file(mapPathName.c_str());
 
@@ -168,9 +188,9 @@ bool Map::Load(std::string path, std::string fileName)
         for (pugi::xml_node tilesetNode = mapFileXML.child("map").child("tileset"); tilesetNode != NULL; tilesetNode = tilesetNode.next_sibling("tileset"))
         {
             //Load Tileset attributes
-            TileSet* tileSet = new TileSet();
+            TileSet* tileSet = arena.New<TileSet>();
             tileSet->firstGid = tilesetNode.attribute("firstgid").as_int();
-            tileSet->name = tilesetNode.attribute("name").as_string();
+            tileSet->name = arena.NewString(tilesetNode.attribute("name").as_string());
             tileSet->tileWidth = tilesetNode.attribute("tilewidth").as_int();
             tileSet->tileHeight = tilesetNode.attribute("tileheight").as_int();
             tileSet->spacing = tilesetNode.attribute("spacing").as_int();
@@ -178,9 +198,12 @@ bool Map::Load(std::string path, std::string fileName)
             tileSet->tileCount = tilesetNode.attribute("tilecount").as_int();
             tileSet->columns = tilesetNode.attribute("columns").as_int();
 
-            //Load the tileset image
+            //Load the tileset image into the level atlas, GetRect adds its offset in the page
             std::string imgName = tilesetNode.child("image").attribute("source").as_string();
-            tileSet->texture = Engine::GetInstance().textures->Load((mapPath + imgName).c_str());
+            TextureRegion region = Engine::GetInstance().textures->LoadRegion((mapPath + imgName).c_str(), AtlasGroup::LEVEL);
+            tileSet->texture = region.texture;
+            tileSet->atlasX = region.rect.x;
+            tileSet->atlasY = region.rect.y;
 
             mapData.tilesets.push_back(tileSet);
         }
@@ -190,9 +213,9 @@ bool Map::Load(std::string path, std::string fileName)
 
             // L07: TODO 4: Implement the load of a single layer 
             //Load the attributes and saved in a new MapLayer
-            MapLayer* mapLayer = new MapLayer();
+            MapLayer* mapLayer = arena.New<MapLayer>();
             mapLayer->id = layerNode.attribute("id").as_int();
-            mapLayer->name = layerNode.attribute("name").as_string();
+            mapLayer->name = arena.NewString(layerNode.attribute("name").as_string());
             mapLayer->width = layerNode.attribute("width").as_int();
             mapLayer->height = layerNode.attribute("height").as_int();
 
@@ -200,8 +223,37 @@ bool Map::Load(std::string path, std::string fileName)
             LoadProperties(layerNode, mapLayer->properties);
 
             //Iterate over all the tiles and assign the values in the data array
-            for (pugi::xml_node tileNode = layerNode.child("data").child("tile"); tileNode != NULL; tileNode = tileNode.next_sibling("tile")) {
-                mapLayer->tiles.push_back(tileNode.attribute("gid").as_int());
+            pugi::xml_node dataNode = layerNode.child("data");
+            std::string encoding = dataNode.attribute("encoding").as_string();
+            // Zero filled, so Get() stays inside the data even if the layer is short
+            size_t tileCount = (size_t)mapLayer->width * mapLayer->height;
+            mapLayer->tiles = arena.NewArray<int>(tileCount);
+            size_t loaded = 0;
+
+            if (encoding == "csv") {
+                // Comma separated gids: much smaller and faster to parse than one <tile> per gid
+                const char* text = dataNode.child_value();
+                char* end = nullptr;
+                while (*text != '\0') {
+                    long gid = strtol(text, &end, 10);
+                    if (end == text) { ++text; continue; }
+                    if (loaded < tileCount) mapLayer->tiles[loaded] = (int)gid;
+                    ++loaded;
+                    text = end;
+                }
+            }
+            else if (!encoding.empty()) {
+                LOG("Layer %s: unsupported data encoding '%s' (use XML or CSV)", mapLayer->name, encoding.c_str());
+            }
+            else {
+                for (pugi::xml_node tileNode = dataNode.child("tile"); tileNode != NULL; tileNode = tileNode.next_sibling("tile")) {
+                    if (loaded < tileCount) mapLayer->tiles[loaded] = tileNode.attribute("gid").as_int();
+                    ++loaded;
+                }
+            }
+
+            if (loaded != tileCount) {
+                LOG("Layer %s: %d tiles for %dx%d", mapLayer->name, (int)loaded, mapLayer->width, mapLayer->height);
             }
 
             //add the layer to the map
@@ -213,15 +265,15 @@ bool Map::Load(std::string path, std::string fileName)
             imageLayerNode != NULL;
             imageLayerNode = imageLayerNode.next_sibling("imagelayer"))
         {
-            ImageLayer* imageLayer = new ImageLayer();
+            ImageLayer* imageLayer = arena.New<ImageLayer>();
             imageLayer->id = imageLayerNode.attribute("id").as_int();
-            imageLayer->name = imageLayerNode.attribute("name").as_string();
+            imageLayer->name = arena.NewString(imageLayerNode.attribute("name").as_string());
             imageLayer->repeatX = imageLayerNode.attribute("repeatx").as_int() == 1;
 
             // Load the image
             pugi::xml_node imageNode = imageLayerNode.child("image");
             if (imageNode) {
-                imageLayer->imagePath = imageNode.attribute("source").as_string();
+                imageLayer->imagePath = arena.NewString(imageNode.attribute("source").as_string());
                 imageLayer->width = imageNode.attribute("width").as_int();
                 imageLayer->height = imageNode.attribute("height").as_int();
 
@@ -229,7 +281,7 @@ bool Map::Load(std::string path, std::string fileName)
                 imageLayer->texture = Engine::GetInstance().textures->Load((mapPath + imageLayer->imagePath).c_str());
 
                 if (imageLayer->texture) {
-                    LOG("Loaded background image: %s", imageLayer->imagePath.c_str());
+                    LOG("Loaded background image: %s", imageLayer->imagePath);
                 }
                 else {
                     LOG("ERROR: Could not load background image: %s", (mapPath + imageLayer->imagePath).c_str());
@@ -261,28 +313,43 @@ bool Map::Load(std::string path, std::string fileName)
                     LOG("Player spawn found at: (%.2f, %.2f)", mapData.playerSpawnX, mapData.playerSpawnY);
                 }
                 else if (objectName.find("Checkpoint") != std::string::npos || objectName == "Spawn2" || objectName == "Spawn3") {
-                    Checkpoint* checkpoint = new Checkpoint();
+                    Checkpoint* checkpoint = arena.New<Checkpoint>();
                     checkpoint->id = objectNode.attribute("id").as_int();
-                    checkpoint->name = objectName;
+                    checkpoint->name = arena.NewString(objectName.c_str());
 
                     checkpoint->x = objectNode.attribute("x").as_float();
                     checkpoint->y = objectNode.attribute("y").as_float();
                     checkpoint->activated = false;
 
                     mapData.checkpoints.push_back(checkpoint);
-                    LOG("  *** CHECKPOINT CARGADO: '%s' at (%.2f, %.2f) ***", checkpoint->name.c_str(), checkpoint->x, checkpoint->y);
+
+                    SDL_FRect bounds = { checkpoint->x - CHECKPOINT_TRIGGER_RADIUS, checkpoint->y - CHECKPOINT_TRIGGER_RADIUS,
+                        CHECKPOINT_TRIGGER_RADIUS * 2.0f, CHECKPOINT_TRIGGER_RADIUS * 2.0f };
+                    int triggerId = triggers.AddTrigger(TriggerType::CHECKPOINT, bounds, objectName);
+                    triggers.GetTrigger(triggerId)->checkpoint = checkpoint;
+
+                    LOG("  *** CHECKPOINT CARGADO: '%s' at (%.2f, %.2f) ***", checkpoint->name, checkpoint->x, checkpoint->y);
+                }
+                else if (objectName.find("SpawnZone") != std::string::npos || groupName == "SpawnZones") {
+                    triggers.AddTrigger(TriggerType::SPAWN_ZONE, GetObjectBounds(objectNode), objectName);
+                    LOG("Spawn zone '%s' loaded", objectName.c_str());
+                }
+                else if (objectName.find("LevelExit") != std::string::npos || groupName == "Exits") {
+                    triggers.AddTrigger(TriggerType::LEVEL_EXIT, GetObjectBounds(objectNode), objectName);
+                    LOG("Level exit '%s' loaded", objectName.c_str());
                 }
                 else if (objectName == "Coin" || groupName == "Coins") {
                     float x = objectNode.attribute("x").as_float();
                     float y = objectNode.attribute("y").as_float();
 
                     std::shared_ptr<Item> coin = std::dynamic_pointer_cast<Item>(
-                        Engine::GetInstance().entityManager->CreateEntity(EntityType::ITEM)
+                        Engine::GetInstance().entityManager->CreateLevelEntity(EntityType::ITEM)
                     );
 
-                    int texW = 0, texH = 0;
-                    SDL_Texture* tempTex = Engine::GetInstance().textures->Load("Assets/Textures/goldCoin.png");
-                    Engine::GetInstance().textures->GetSize(tempTex, texW, texH);
+                    // Same region Item::Start gets, the image is only loaded once
+                    SDL_Rect coinRect = Engine::GetInstance().textures->LoadRegion("Assets/Textures/goldCoin.png", AtlasGroup::COMMON).rect;
+                    int texW = coinRect.w;
+                    int texH = coinRect.h;
 
                     coin->position = Vector2D(x - texW / 2 + 15, y - texH);
 
@@ -294,9 +361,18 @@ bool Map::Load(std::string path, std::string fileName)
         // L08 TODO 7: Assign collider type
         // Later you can create a function here to load and create the colliders from the map
 
+        // Bake the collision classes into bitsets for the grid queries
+        for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+            mapData.tileClasses[c].Resize(mapData.width, mapData.height);
+        }
+
         //Iterate the layer and create colliders
+        // Boxes per collider type, each type becomes one static body
+        std::vector<SDL_Rect> solidRects;
+        std::vector<SDL_Rect> damageRects;
+        std::vector<SDL_Rect> oneWayRects;
         for (const auto& mapLayer : mapData.layers) {
-            if (mapLayer->name == "Collisions") {
+            if (strcmp(mapLayer->name, "Collisions") == 0) {
                 for (int i = 0; i < mapData.height; i++) {
                     for (int j = 0; j < mapData.width; j++) {
                         int gid = mapLayer->Get(i, j);
@@ -310,48 +386,27 @@ bool Map::Load(std::string path, std::string fileName)
                         if (tileset == nullptr) continue;
 
                         // Plataformas ONE-WAY (tileset "MapData" - tu azul)
-                        if (tileset->name == "MapData") {
-                            PhysBody* oneWay = Engine::GetInstance().physics.get()->CreateRectangleSensor(
-                                mapCoord.getX() + mapData.tileWidth / 2,
-                                mapCoord.getY() + mapData.tileHeight / 2,
-                                mapData.tileWidth,
-                                mapData.tileHeight,
-                                STATIC
-                            );
-                            oneWay->ctype = ColliderType::PLATFORM_ONEWAY;
-                            LOG("Created ONE-WAY platform at (%d, %d) - GID: %d", (int)mapCoord.getX(), (int)mapCoord.getY(), gid);
+                        if (strcmp(tileset->name, "MapData") == 0) {
+                            // Bodies are created below, merged per row
+                            mapData.tileClasses[TILE_ONEWAY].Set(j, i);
                         }
                         // Plataformas NORMALES (tileset "MapMetadata" - GID 1 y 2)
-                        else if (tileset->name == "MapMetadata") {
-                            PhysBody* c1 = Engine::GetInstance().physics.get()->CreateRectangle(
-                                mapCoord.getX() + mapData.tileWidth / 2,
-                                mapCoord.getY() + mapData.tileHeight / 2,
-                                mapData.tileWidth,
-                                mapData.tileHeight,
-                                STATIC
-                            );
-                            c1->ctype = ColliderType::PLATFORM;
-                            LOG("Created NORMAL platform at (%d, %d) - GID: %d", (int)mapCoord.getX(), (int)mapCoord.getY(), gid);
+                        else if (strcmp(tileset->name, "MapMetadata") == 0) {
+                            solidRects.push_back({ (int)mapCoord.getX(), (int)mapCoord.getY(), mapData.tileWidth, mapData.tileHeight });
+                            mapData.tileClasses[TILE_SOLID].Set(j, i);
                         }
                     }
                 }
             }
-            if (mapLayer->name == "Damage") {
+            if (strcmp(mapLayer->name, "Damage") == 0) {
                 for (int y = 0; y < mapData.height; y++) {
                     for (int x = 0; x < mapData.width; x++) {
                         int gid = mapLayer->Get(y, x);
 
                         if (gid == 2) {  // Verde = daño
                             Vector2D mapCoord = MapToWorld(y, x);
-                            PhysBody* c2 = Engine::GetInstance().physics.get()->CreateRectangle(
-                                mapCoord.getX() + mapData.tileWidth / 2,
-                                mapCoord.getY() + mapData.tileHeight / 2,
-                                mapData.tileWidth,
-                                mapData.tileHeight,
-                                STATIC
-                            );
-                            c2->ctype = ColliderType::ENEMY;
-                            LOG("Created DAMAGE collider at (%d, %d)", (int)mapCoord.getX(), (int)mapCoord.getY());
+                            damageRects.push_back({ (int)mapCoord.getX(), (int)mapCoord.getY(), mapData.tileWidth, mapData.tileHeight });
+                            mapData.tileClasses[TILE_DAMAGE].Set(x, y);
                         }
                     }
                 }
@@ -359,6 +414,39 @@ bool Map::Load(std::string path, std::string fileName)
 
         }
 
+        // Merge each horizontal run of one-way tiles into a single platform
+        const TileBitset& oneWayTiles = mapData.tileClasses[TILE_ONEWAY];
+        for (int i = 0; i < mapData.height; i++) {
+            int j = 0;
+            while (j < mapData.width) {
+                if (!oneWayTiles.Get(j, i)) { j++; continue; }
+
+                int start = j;
+                while (j < mapData.width && oneWayTiles.Get(j, i)) j++;
+
+                Vector2D mapCoord = MapToWorld(i, start);
+                oneWayRects.push_back({ (int)mapCoord.getX(), (int)mapCoord.getY(), (j - start) * mapData.tileWidth, mapData.tileHeight });
+            }
+        }
+
+        Physics* physics = Engine::GetInstance().physics.get();
+        if (!solidRects.empty()) mapData.colliders.push_back(physics->CreateStaticBoxes(solidRects.data(), (int)solidRects.size(), ColliderType::PLATFORM));
+        if (!damageRects.empty()) mapData.colliders.push_back(physics->CreateStaticBoxes(damageRects.data(), (int)damageRects.size(), ColliderType::ENEMY));
+        if (!oneWayRects.empty()) mapData.colliders.push_back(physics->CreateStaticBoxes(oneWayRects.data(), (int)oneWayRects.size(), ColliderType::PLATFORM_ONEWAY));
+
+        // One line per map: per-tile logs made big maps take minutes to load
+        LOG("Created %d NORMAL, %d DAMAGE and %d ONE-WAY colliders", (int)solidRects.size(), (int)damageRects.size(), (int)oneWayRects.size());
+
+        // Tile arrays and collision bitsets, per layer
+        int64_t mapBytes = 0;
+        for (const auto& mapLayer : mapData.layers) {
+            mapBytes += (int64_t)mapLayer->width * mapLayer->height * (int64_t)sizeof(int);
+        }
+        for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+            mapBytes += (int64_t)(mapData.tileClasses[c].bits.capacity() * sizeof(uint64_t));
+        }
+        MemoryTracker::Set(MemTag::MAP, mapBytes, (int64_t)mapData.layers.size());
+
         ret = true;
 
         // L06: TODO 5: LOG all the data loaded iterate all tilesetsand LOG everything
@@ -371,21 +459,26 @@ bool Map::Load(std::string path, std::string fileName)
 
             //iterate the tilesets
             for (const auto& tileset : mapData.tilesets) {
-                LOG("name : %s firstgid : %d", tileset->name.c_str(), tileset->firstGid);
+                LOG("name : %s firstgid : %d", tileset->name, tileset->firstGid);
                 LOG("tile width : %d tile height : %d", tileset->tileWidth, tileset->tileHeight);
                 LOG("spacing : %d margin : %d", tileset->spacing, tileset->margin);
+                LOG("atlas offset : %d, %d", tileset->atlasX, tileset->atlasY);
             }
 
+            float occupancy = 0.0f;
+            int pages = Engine::GetInstance().textures->GetAtlasPageCount(AtlasGroup::LEVEL, occupancy);
+            LOG("%d tilesets in %d atlas pages (%.0f%% used)", (int)mapData.tilesets.size(), pages, occupancy * 100.0f);
+
             LOG("Layers----");
 
             for (const auto& layer : mapData.layers) {
-                LOG("id : %d name : %s", layer->id, layer->name.c_str());
+                LOG("id : %d name : %s", layer->id, layer->name);
                 LOG("Layer width : %d Layer height : %d", layer->width, layer->height);
             }
 
             LOG("Image Layers----");
             for (const auto& imageLayer : mapData.imageLayers) {
-                LOG("id : %d name : %s image : %s", imageLayer->id, imageLayer->name.c_str(), imageLayer->imagePath.c_str());
+                LOG("id : %d name : %s image : %s", imageLayer->id, imageLayer->name, imageLayer->imagePath);
             }
         }
         else {
@@ -415,19 +508,168 @@ Vector2D Map::MapToWorld(int i, int j) const
 bool Map::LoadProperties(pugi::xml_node& node, Properties& properties)
 {
     bool ret = false;
+    LevelArena& arena = Engine::GetInstance().GetLevelArena();
+
+    // Appended in file order
+    Properties::Property** tail = &properties.first;
+    while (*tail != nullptr) tail = &(*tail)->next;
 
     for (pugi::xml_node propertieNode = node.child("properties").child("property"); propertieNode; propertieNode = propertieNode.next_sibling("property"))
     {
-        Properties::Property* p = new Properties::Property();
-        p->name = propertieNode.attribute("name").as_string();
+        Properties::Property* p = arena.New<Properties::Property>();
+        p->name = arena.NewString(propertieNode.attribute("name").as_string());
         p->value = propertieNode.attribute("value").as_bool(); // (!!) I'm assuming that all values are bool !!
+        p->next = nullptr;
 
-        properties.propertyList.push_back(p);
+        *tail = p;
+        tail = &p->next;
     }
 
     return ret;
 }
 
+// Bounds of a TMX object, point objects get a checkpoint sized box
+SDL_FRect Map::GetObjectBounds(pugi::xml_node& objectNode) const
+{
+    SDL_FRect bounds;
+    bounds.x = objectNode.attribute("x").as_float();
+    bounds.y = objectNode.attribute("y").as_float();
+    bounds.w = objectNode.attribute("width").as_float();
+    bounds.h = objectNode.attribute("height").as_float();
+
+    if (bounds.w <= 0.0f || bounds.h <= 0.0f) {
+        bounds.x -= CHECKPOINT_TRIGGER_RADIUS;
+        bounds.y -= CHECKPOINT_TRIGGER_RADIUS;
+        bounds.w = CHECKPOINT_TRIGGER_RADIUS * 2.0f;
+        bounds.h = CHECKPOINT_TRIGGER_RADIUS * 2.0f;
+    }
+    // Tile objects are anchored at their bottom-left corner
+    else if (objectNode.attribute("gid")) {
+        bounds.y -= bounds.h;
+    }
+
+    return bounds;
+}
+
+void Map::WorldToMap(float x, float y, int& tx, int& ty) const
+{
+    tx = (int)floorf(x / mapData.tileWidth);
+    ty = (int)floorf(y / mapData.tileHeight);
+}
+
+bool Map::TestTile(int tx, int ty, unsigned int classMask) const
+{
+    for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+        if ((classMask & (1u << c)) && mapData.tileClasses[c].Get(tx, ty)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TileBitset::AnyInRow(int ty, int x0, int x1) const
+{
+    if (ty < 0 || ty >= height) return false;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= width) x1 = width - 1;
+    if (x0 > x1) return false;
+
+    const uint64_t* row = &bits[(size_t)ty * wordsPerRow];
+    int w0 = x0 >> 6;
+    int w1 = x1 >> 6;
+    uint64_t firstMask = ~(uint64_t)0 << (x0 & 63);
+    uint64_t lastMask = ~(uint64_t)0 >> (63 - (x1 & 63));
+
+    if (w0 == w1) return (row[w0] & firstMask & lastMask) != 0;
+
+    if (row[w0] & firstMask) return true;
+    for (int w = w0 + 1; w < w1; ++w) {
+        if (row[w]) return true;
+    }
+    return (row[w1] & lastMask) != 0;
+}
+
+bool Map::OverlapsTiles(const SDL_FRect& aabb, unsigned int classMask) const
+{
+    if (!mapLoaded || aabb.w <= 0.0f || aabb.h <= 0.0f) return false;
+
+    // Touching the right / bottom edge of a tile does not count as overlap
+    int tx0, ty0, tx1, ty1;
+    WorldToMap(aabb.x, aabb.y, tx0, ty0);
+    WorldToMap(aabb.x + aabb.w - 0.001f, aabb.y + aabb.h - 0.001f, tx1, ty1);
+
+    for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+        if (!(classMask & (1u << c))) continue;
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            if (mapData.tileClasses[c].AnyInRow(ty, tx0, tx1)) return true;
+        }
+    }
+    return false;
+}
+
+bool Map::RaycastTiles(float x0, float y0, float x1, float y1, unsigned int classMask, TileRayHit& hit) const
+{
+    hit = TileRayHit();
+    if (!mapLoaded) return false;
+
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float tw = (float)mapData.tileWidth;
+    const float th = (float)mapData.tileHeight;
+
+    int tx, ty;
+    WorldToMap(x0, y0, tx, ty);
+    int endX, endY;
+    WorldToMap(x1, y1, endX, endY);
+
+    const int stepX = (dx > 0.0f) ? 1 : (dx < 0.0f ? -1 : 0);
+    const int stepY = (dy > 0.0f) ? 1 : (dy < 0.0f ? -1 : 0);
+
+    // Ray parameter at the next vertical / horizontal tile boundary, and per tile
+    float tMaxX = (stepX != 0) ? (((stepX > 0 ? tx + 1 : tx) * tw) - x0) / dx : INFINITY;
+    float tMaxY = (stepY != 0) ? (((stepY > 0 ? ty + 1 : ty) * th) - y0) / dy : INFINITY;
+    const float tDeltaX = (stepX != 0) ? tw / fabsf(dx) : INFINITY;
+    const float tDeltaY = (stepY != 0) ? th / fabsf(dy) : INFINITY;
+
+    float t = 0.0f;
+    int normalX = 0;
+    int normalY = 0;
+    const int maxSteps = abs(endX - tx) + abs(endY - ty) + 1;
+
+    for (int i = 0; i < maxSteps; ++i) {
+        if (TestTile(tx, ty, classMask)) {
+            hit.hit = true;
+            hit.tileX = tx;
+            hit.tileY = ty;
+            hit.fraction = t;
+            hit.x = x0 + dx * t;
+            hit.y = y0 + dy * t;
+            hit.normalX = normalX;
+            hit.normalY = normalY;
+            return true;
+        }
+
+        if (tMaxX < tMaxY) {
+            t = tMaxX;
+            tMaxX += tDeltaX;
+            tx += stepX;
+            normalX = -stepX;
+            normalY = 0;
+        }
+        else {
+            t = tMaxY;
+            tMaxY += tDeltaY;
+            ty += stepY;
+            normalX = 0;
+            normalY = -stepY;
+        }
+
+        if (t > 1.0f) break;
+    }
+
+    return false;
+}
+
 // L10: TODO 7: Create a method to get the map size in pixels
 Vector2D Map::GetMapSizeInPixels()
 {
@@ -447,17 +689,4 @@ Vector2D Map::GetPlayerSpawnPosition()
 
 std::vector<Checkpoint*> Map::GetCheckpoints() {
     return mapData.checkpoints;
-}
-
-Checkpoint* Map::GetCheckpointAt(float x, float y, float radius) {
-    for (auto checkpoint : mapData.checkpoints) {
-        float dx = checkpoint->x - x;
-        float dy = checkpoint->y - y;
-        float distance = sqrt(dx * dx + dy * dy);
-
-        if (distance <= radius) {
-            return checkpoint;
-        }
-    }
-    return nullptr;
 }
\ No newline at end of file
@@ -1,35 +1,34 @@
 #pragma once
 
 #include "Module.h"
-#include <list>
+#include "Triggers.h"
+#include "Physics.h"
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Half size of the trigger volume placed on point checkpoints
+#define CHECKPOINT_TRIGGER_RADIUS 32.0f
 
 // L09: TODO 5: Add attributes to the property structure
 struct Properties
 {
     struct Property
     {
-        std::string name;
+        const char* name;
         bool value; //We assume that we are going to work only with bool for the moment
+        Property* next;
     };
 
-    std::list<Property*> propertyList;
-
-    ~Properties()
-    {
-        for (const auto& property : propertyList)
-        {
-            delete property;
-        }
-
-        propertyList.clear();
-    }
+    // Linked through the properties themselves, all in the level arena
+    Property* first = nullptr;
 
     // L09: DONE 7: Method to ask for the value of a custom property
     Property* GetProperty(const char* name)
     {
-        for (const auto& property : propertyList) {
-            if (property->name == name) {
+        for (Property* property = first; property != nullptr; property = property->next) {
+            if (strcmp(property->name, name) == 0) {
                 return property;
             }
         }
@@ -43,10 +42,10 @@ struct MapLayer
 {
     // L07: TODO 1: Add the info to the MapLayer Struct
     int id;
-    std::string name;
+    const char* name;
     int width;
     int height;
-    std::vector<int> tiles;
+    int* tiles;             // width * height gids, in the level arena
     Properties properties;
 
     // L07: TODO 6: Short function to get the gid value of i,j
@@ -62,14 +61,16 @@ struct MapLayer
 struct TileSet
 {
     int firstGid;
-    std::string name;
+    const char* name;
     int tileWidth;
     int tileHeight;
     int spacing;
     int margin;
     int tileCount;
     int columns;
-    SDL_Texture* texture;
+    SDL_Texture* texture;   // atlas page holding the tileset image
+    int atlasX = 0;         // position of the image in the page
+    int atlasY = 0;
 
     // L07: TODO 7: Implement the method that receives the gid and returns a Rect
     SDL_Rect GetRect(unsigned int gid) {
@@ -78,8 +79,8 @@ struct TileSet
         int relativeIndex = gid - firstGid;
         rect.w = tileWidth;
         rect.h = tileHeight;
-        rect.x = margin + (tileWidth + spacing) * (relativeIndex % columns);
-        rect.y = margin + (tileHeight + spacing) * (relativeIndex / columns);
+        rect.x = atlasX + margin + (tileWidth + spacing) * (relativeIndex % columns);
+        rect.y = atlasY + margin + (tileHeight + spacing) * (relativeIndex / columns);
 
         return rect;
     }
@@ -89,28 +90,101 @@ struct TileSet
 struct ImageLayer
 {
     int id;
-    std::string name;
-    std::string imagePath;
+    const char* name;
+    const char* imagePath;
     SDL_Texture* texture;
     int width;
     int height;
     bool repeatX;
 
-    ImageLayer() : id(0), texture(nullptr), width(0), height(0), repeatX(false) {}
+    ImageLayer() : id(0), name(""), imagePath(""), texture(nullptr), width(0), height(0), repeatX(false) {}
 };
 
 struct Checkpoint {
     int id;
-    std::string name;
+    const char* name;
     float x;
     float y;
     bool activated;
 
-    Checkpoint() : id(0), x(0.0f), y(0.0f), activated(false) {}
+    Checkpoint() : id(0), name(""), x(0.0f), y(0.0f), activated(false) {}
+};
+
+// Map data lives in the level arena and is released with it: none of it may need a destructor
+static_assert(std::is_trivially_destructible<Properties::Property>::value, "Property must be trivially destructible");
+static_assert(std::is_trivially_destructible<MapLayer>::value, "MapLayer must be trivially destructible");
+static_assert(std::is_trivially_destructible<TileSet>::value, "TileSet must be trivially destructible");
+static_assert(std::is_trivially_destructible<ImageLayer>::value, "ImageLayer must be trivially destructible");
+static_assert(std::is_trivially_destructible<Checkpoint>::value, "Checkpoint must be trivially destructible");
+
+// Collision classes baked from the Collisions / Damage layers
+enum TileClass
+{
+    TILE_SOLID = 0,
+    TILE_ONEWAY,
+    TILE_DAMAGE,
+    TILE_CLASS_COUNT
+};
+
+#define TILE_MASK_SOLID  (1u << TILE_SOLID)
+#define TILE_MASK_ONEWAY (1u << TILE_ONEWAY)
+#define TILE_MASK_DAMAGE (1u << TILE_DAMAGE)
+#define TILE_MASK_GROUND (TILE_MASK_SOLID | TILE_MASK_ONEWAY)
+
+// One bit per tile, rows padded to whole 64-bit words
+struct TileBitset
+{
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+
+    void Resize(int w, int h)
+    {
+        width = w;
+        height = h;
+        wordsPerRow = (w + 63) / 64;
+        bits.assign((size_t)wordsPerRow * h, 0);
+    }
+
+    void Clear()
+    {
+        width = height = wordsPerRow = 0;
+        bits.clear();
+    }
+
+    void Set(int tx, int ty)
+    {
+        bits[(size_t)ty * wordsPerRow + (tx >> 6)] |= (uint64_t)1 << (tx & 63);
+    }
+
+    // Tiles outside the map are empty
+    bool Get(int tx, int ty) const
+    {
+        if (tx < 0 || ty < 0 || tx >= width || ty >= height) return false;
+        return (bits[(size_t)ty * wordsPerRow + (tx >> 6)] >> (tx & 63)) & 1;
+    }
+
+    // Any bit set in the row between x0 and x1 (inclusive, clamped to the map)
+    bool AnyInRow(int ty, int x0, int x1) const;
 };
 
+// Result of a grid raycast, in pixels
+struct TileRayHit
+{
+    bool hit = false;
+    int tileX = 0;
+    int tileY = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    float fraction = 0.0f;  // [0,1] along the ray
+    int normalX = 0;
+    int normalY = 0;
+};
 
 // L06: TODO 1: Create a struct needed to hold the information to Map node
+// Tilesets, layers, checkpoints and colliders are allocated in the level arena (Engine::GetLevelArena);
+// the vectors below only hold pointers and keep their capacity from one level to the next
 struct MapData
 {
 	int width;
@@ -121,14 +195,18 @@ struct MapData
     float playerSpawnX = 0.0f;
     float playerSpawnY = 0.0f;
 
-    std::list<TileSet*> tilesets;
+    std::vector<TileSet*> tilesets;
     std::vector<Checkpoint*> checkpoints;
 
     // L07: TODO 2: Add the info to the MapLayer Struct
-    std::list<MapLayer*> layers;
-    std::list<ImageLayer*> imageLayers;
+    std::vector<MapLayer*> layers;
+    std::vector<ImageLayer*> imageLayers;
 
+    // Tile occupancy per collision class
+    TileBitset tileClasses[TILE_CLASS_COUNT];
 
+    // One static body per collider type, destroyed as a unit
+    std::vector<PhysBody*> colliders;
 };
 
 class Map : public Module
@@ -167,6 +245,24 @@ public:
 	// L10: TODO 7: Create a method to get the map size in pixels
 	Vector2D GetMapSizeInPixels();
 
+    // Bounds in pixels of a TMX <object>
+    SDL_FRect GetObjectBounds(pugi::xml_node& objectNode) const;
+
+    // Grid queries on the baked tile bitsets (tile coordinates)
+    bool IsSolid(int tx, int ty) const { return mapData.tileClasses[TILE_SOLID].Get(tx, ty); }
+    bool IsOneWay(int tx, int ty) const { return mapData.tileClasses[TILE_ONEWAY].Get(tx, ty); }
+    bool IsDamage(int tx, int ty) const { return mapData.tileClasses[TILE_DAMAGE].Get(tx, ty); }
+    bool TestTile(int tx, int ty, unsigned int classMask) const;
+
+    // Does an AABB in pixels touch any tile of the given classes
+    bool OverlapsTiles(const SDL_FRect& aabb, unsigned int classMask) const;
+
+    // DDA walk from (x0,y0) to (x1,y1) in pixels, stops at the first tile of the given classes
+    bool RaycastTiles(float x0, float y0, float x1, float y1, unsigned int classMask, TileRayHit& hit) const;
+
+    // Pixel to tile coordinates
+    void WorldToMap(float x, float y, int& tx, int& ty) const;
+
 public: 
     std::string mapFileName;
     std::string mapPath;
@@ -175,7 +271,9 @@ public:
     
     Vector2D GetPlayerSpawnPosition();
     std::vector<Checkpoint*> GetCheckpoints();
-    Checkpoint* GetCheckpointAt(float x, float y, float radius);
+
+    // Coins, checkpoints, spawn zones and level exits
+    TriggerSystem triggers;
 
 private:
     bool mapLoaded;
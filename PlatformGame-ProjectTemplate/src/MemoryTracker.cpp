@@ -0,0 +1,205 @@
+#include "MemoryTracker.h"
+#include "Log.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+struct TagCounters
+{
+	std::atomic<int64_t> bytes{ 0 };
+	std::atomic<int64_t> count{ 0 };
+	std::atomic<int64_t> heapBytes{ 0 };
+	std::atomic<int64_t> heapAllocs{ 0 };
+};
+
+static TagCounters counters[MEM_TAG_COUNT];
+static std::atomic<int64_t> heapAllocTotal{ 0 };
+static thread_local MemTag threadTag = MemTag::OTHER;
+
+static const char* tagNames[MEM_TAG_COUNT] = { "textures", "audio", "map", "physics", "entities", "arenas", "other" };
+
+int64_t MemorySnapshot::TotalBytes() const
+{
+	int64_t total = 0;
+	for (const MemTagUsage& usage : tags)
+		total += usage.bytes;
+	return total;
+}
+
+int64_t MemorySnapshot::TotalHeapBytes() const
+{
+	int64_t total = 0;
+	for (const MemTagUsage& usage : tags)
+		total += usage.heapBytes;
+	return total;
+}
+
+void MemoryTracker::Add(MemTag tag, int64_t bytes, int64_t count)
+{
+	TagCounters& c = counters[(int)tag];
+	c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+	c.count.fetch_add(count, std::memory_order_relaxed);
+}
+
+void MemoryTracker::Set(MemTag tag, int64_t bytes, int64_t count)
+{
+	TagCounters& c = counters[(int)tag];
+	c.bytes.store(bytes, std::memory_order_relaxed);
+	c.count.store(count, std::memory_order_relaxed);
+}
+
+MemorySnapshot MemoryTracker::Snapshot()
+{
+	MemorySnapshot snapshot;
+	for (int i = 0; i < MEM_TAG_COUNT; ++i)
+	{
+		snapshot.tags[i].bytes = counters[i].bytes.load(std::memory_order_relaxed);
+		snapshot.tags[i].count = counters[i].count.load(std::memory_order_relaxed);
+		snapshot.tags[i].heapBytes = counters[i].heapBytes.load(std::memory_order_relaxed);
+		snapshot.tags[i].heapAllocs = counters[i].heapAllocs.load(std::memory_order_relaxed);
+	}
+	return snapshot;
+}
+
+bool MemoryTracker::IsHeapTracked()
+{
+#ifdef PLATFORMGAME_TRACK_HEAP
+	return true;
+#else
+	return false;
+#endif
+}
+
+int64_t MemoryTracker::GetHeapAllocTotal()
+{
+	return heapAllocTotal.load(std::memory_order_relaxed);
+}
+
+const char* MemoryTracker::TagName(MemTag tag)
+{
+	int index = (int)tag;
+	return index >= 0 && index < MEM_TAG_COUNT ? tagNames[index] : "?";
+}
+
+void MemoryTracker::LogSnapshot(const MemorySnapshot& snapshot, const char* label)
+{
+	LOG("Memory %s: %.1f KB tracked, %.1f KB heap", label, snapshot.TotalBytes() / 1024.0, snapshot.TotalHeapBytes() / 1024.0);
+	for (int i = 0; i < MEM_TAG_COUNT; ++i)
+	{
+		const MemTagUsage& u = snapshot.tags[i];
+		LOG("  %-9s %10.1f KB %7lld objects | heap %10.1f KB %8lld allocs", tagNames[i],
+			u.bytes / 1024.0, (long long)u.count, u.heapBytes / 1024.0, (long long)u.heapAllocs);
+	}
+}
+
+void MemoryTracker::LogDiff(const MemorySnapshot& before, const MemorySnapshot& after, const char* label)
+{
+	LOG("Memory diff %s: %+.1f KB tracked, %+.1f KB heap", label,
+		(after.TotalBytes() - before.TotalBytes()) / 1024.0, (after.TotalHeapBytes() - before.TotalHeapBytes()) / 1024.0);
+
+	// Only the tags that changed
+	for (int i = 0; i < MEM_TAG_COUNT; ++i)
+	{
+		const MemTagUsage& a = before.tags[i];
+		const MemTagUsage& b = after.tags[i];
+		if (a.bytes == b.bytes && a.count == b.count && a.heapBytes == b.heapBytes)
+			continue;
+
+		LOG("  %-9s %+10.1f KB %+7lld objects | heap %+10.1f KB (now %.1f KB)", tagNames[i],
+			(b.bytes - a.bytes) / 1024.0, (long long)(b.count - a.count),
+			(b.heapBytes - a.heapBytes) / 1024.0, b.bytes / 1024.0);
+	}
+}
+
+int MemoryTracker::LogLeaks()
+{
+	MemorySnapshot snapshot = Snapshot();
+	int leaks = 0;
+	for (int i = 0; i < MEM_TAG_COUNT; ++i)
+	{
+		const MemTagUsage& u = snapshot.tags[i];
+		if (u.bytes == 0 && u.count == 0)
+			continue;
+
+		LOG("Memory leak? %s still holds %lld bytes in %lld objects", tagNames[i], (long long)u.bytes, (long long)u.count);
+		++leaks;
+	}
+	return leaks;
+}
+
+MemTag MemoryTracker::SetThreadTag(MemTag tag)
+{
+	MemTag previous = threadTag;
+	threadTag = tag;
+	return previous;
+}
+
+MemTag MemoryTracker::GetThreadTag()
+{
+	return threadTag;
+}
+
+#ifdef PLATFORMGAME_TRACK_HEAP
+
+// Every block carries its size and tag in front, so delete can credit the right tag
+struct HeapHeader
+{
+	size_t size;
+	int tag;
+};
+
+#define HEAP_HEADER_SIZE ((sizeof(HeapHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1))
+
+void* operator new(size_t size)
+{
+	unsigned char* block = static_cast<unsigned char*>(std::malloc(HEAP_HEADER_SIZE + size));
+	if (block == nullptr)
+		throw std::bad_alloc();
+
+	HeapHeader* header = reinterpret_cast<HeapHeader*>(block);
+	header->size = size;
+	header->tag = (int)threadTag;
+
+	TagCounters& c = counters[header->tag];
+	c.heapBytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+	c.heapAllocs.fetch_add(1, std::memory_order_relaxed);
+	heapAllocTotal.fetch_add(1, std::memory_order_relaxed);
+	return block + HEAP_HEADER_SIZE;
+}
+
+void operator delete(void* p) noexcept
+{
+	if (p == nullptr)
+		return;
+
+	unsigned char* block = static_cast<unsigned char*>(p) - HEAP_HEADER_SIZE;
+	HeapHeader* header = reinterpret_cast<HeapHeader*>(block);
+
+	TagCounters& c = counters[header->tag];
+	c.heapBytes.fetch_sub((int64_t)header->size, std::memory_order_relaxed);
+	c.heapAllocs.fetch_sub(1, std::memory_order_relaxed);
+	std::free(block);
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete[](void* p) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+#endif
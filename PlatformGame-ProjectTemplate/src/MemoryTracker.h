@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+// Subsystems the memory is accounted to
+enum class MemTag
+{
+	TEXTURES,
+	AUDIO,
+	MAP,
+	PHYSICS,
+	ENTITIES,
+	ARENAS,
+	OTHER,
+	COUNT
+};
+
+#define MEM_TAG_COUNT ((int)MemTag::COUNT)
+
+struct MemTagUsage
+{
+	int64_t bytes = 0;       // reported by the subsystem (texture pixels, PCM samples, tiles...)
+	int64_t count = 0;       // objects of the subsystem (textures, effects, layers, bodies...)
+	int64_t heapBytes = 0;   // live operator new blocks made while the tag was current,
+	int64_t heapAllocs = 0;  // 0 without PLATFORMGAME_TRACK_HEAP
+};
+
+struct MemorySnapshot
+{
+	MemTagUsage tags[MEM_TAG_COUNT];
+
+	int64_t TotalBytes() const;
+	int64_t TotalHeapBytes() const;
+};
+
+// Per-subsystem memory accounting. Subsystems report their own usage with Add / Set, and when the
+// game is built with PLATFORMGAME_TRACK_HEAP the global operator new / delete are also counted
+// under the tag of the current MemScope. Thread safe.
+class MemoryTracker
+{
+public:
+
+	// Relative change (negative to release)
+	static void Add(MemTag tag, int64_t bytes, int64_t count);
+
+	// Absolute usage, for subsystems that can report their total at once
+	static void Set(MemTag tag, int64_t bytes, int64_t count);
+
+	static MemorySnapshot Snapshot();
+
+	static bool IsHeapTracked();
+
+	// operator new calls since the start, with PLATFORMGAME_TRACK_HEAP
+	static int64_t GetHeapAllocTotal();
+	static const char* TagName(MemTag tag);
+
+	static void LogSnapshot(const MemorySnapshot& snapshot, const char* label);
+
+	// Per tag differences between two snapshots (e.g. before and after a level load)
+	static void LogDiff(const MemorySnapshot& before, const MemorySnapshot& after, const char* label);
+
+	// Logs the tags whose subsystems still report memory, returns how many (call after every module is
+	// cleaned up). The heap columns are left out: module objects and containers outlive CleanUp
+	static int LogLeaks();
+
+	// Tag the heap hooks use on this thread, returns the previous one
+	static MemTag SetThreadTag(MemTag tag);
+	static MemTag GetThreadTag();
+};
+
+// Sets the heap tag of this thread for the lifetime of the scope
+class MemScope
+{
+public:
+
+	explicit MemScope(MemTag tag) : previous(MemoryTracker::SetThreadTag(tag)) {}
+	~MemScope() { MemoryTracker::SetThreadTag(previous); }
+
+	MemScope(const MemScope&) = delete;
+	MemScope& operator=(const MemScope&) = delete;
+
+private:
+
+	MemTag previous;
+};
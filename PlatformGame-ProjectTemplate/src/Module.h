@@ -2,6 +2,7 @@
 
 #include <string>
 #include "pugixml.hpp"
+#include "MemoryTracker.h"
 
 class Module
 {
@@ -67,4 +68,7 @@ public:
 	//L05 TODO 4a: Declare a pugi::xml_node to store the module configuration parameters
 	pugi::xml_node configParameters;
 
+	// Heap allocations made inside the module calls are accounted to this tag
+	MemTag memTag = MemTag::OTHER;
+
 };
\ No newline at end of file
@@ -0,0 +1,405 @@
+#include "MusicStream.h"
+#include "Log.h"
+
+#include <string.h>
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+static Uint16 ReadLE16(const Uint8* p) { return (Uint16)(p[0] | (p[1] << 8)); }
+static Uint32 ReadLE32(const Uint8* p) { return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24); }
+
+//
+//--------------- WavDecoder --------------------
+//
+
+WavDecoder::~WavDecoder() {
+    Close();
+}
+
+bool WavDecoder::Open(const char* path) {
+    Close();
+
+    io_ = SDL_IOFromFile(path, "rb");
+    if (!io_) {
+        LOG("Music: cannot open %s: %s", path, SDL_GetError());
+        return false;
+    }
+
+    Uint8 header[12];
+    if (SDL_ReadIO(io_, header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        LOG("Music: %s is not a RIFF/WAVE file", path);
+        Close();
+        return false;
+    }
+
+    // Walk the chunks, only the header fields are kept in memory
+    bool haveFormat = false;
+    bool haveData = false;
+    Uint32 dataBytes = 0;
+    Uint8 chunk[8];
+    while (SDL_ReadIO(io_, chunk, 8) == 8) {
+        Uint32 size = ReadLE32(chunk + 4);
+        Sint64 next = SDL_TellIO(io_) + size + (size & 1);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            Uint8 fmt[40] = {};
+            SDL_ReadIO(io_, fmt, size < sizeof(fmt) ? size : sizeof(fmt));
+            Uint16 tag = ReadLE16(fmt);
+            if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 26) tag = ReadLE16(fmt + 24); // sub format GUID
+            spec.channels = ReadLE16(fmt + 2);
+            spec.freq = (int)ReadLE32(fmt + 4);
+            bits_ = ReadLE16(fmt + 14);
+            isFloat_ = tag == WAVE_FORMAT_IEEE_FLOAT;
+            haveFormat = (tag == WAVE_FORMAT_PCM && (bits_ == 8 || bits_ == 16 || bits_ == 24 || bits_ == 32)) ||
+                (isFloat_ && bits_ == 32);
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            dataOffset_ = SDL_TellIO(io_);
+            dataBytes = size;
+            haveData = true;
+        }
+        else if (memcmp(chunk, "smpl", 4) == 0 && size >= 36 + 24) {
+            // Sampler chunk: 36 bytes of header, then the first loop (start / end are inclusive frames)
+            Uint8 smpl[36 + 24];
+            SDL_ReadIO(io_, smpl, sizeof(smpl));
+            if (ReadLE32(smpl + 28) > 0) {
+                loopStart = (int)ReadLE32(smpl + 36 + 8);
+                loopEnd = (int)ReadLE32(smpl + 36 + 12) + 1;
+            }
+        }
+
+        if (SDL_SeekIO(io_, next, SDL_IO_SEEK_SET) < 0) break;
+    }
+
+    if (!haveFormat || !haveData || spec.channels <= 0 || spec.channels > MUSIC_MAX_CHANNELS) {
+        LOG("Music: unsupported WAV layout in %s (%d bits, %d channels)", path, bits_, spec.channels);
+        Close();
+        return false;
+    }
+
+    spec.format = SDL_AUDIO_F32;
+    totalFrames = (int)(dataBytes / ((bits_ / 8) * spec.channels));
+    if (loopEnd <= loopStart || loopEnd > totalFrames) {
+        loopStart = 0;
+        loopEnd = 0;
+    }
+
+    return Seek(0);
+}
+
+void WavDecoder::Close() {
+    if (io_) {
+        SDL_CloseIO(io_);
+        io_ = nullptr;
+    }
+}
+
+bool WavDecoder::Seek(int frame) {
+    if (!io_) return false;
+    if (frame < 0) frame = 0;
+    if (frame > totalFrames) frame = totalFrames;
+
+    const Sint64 offset = dataOffset_ + (Sint64)frame * (bits_ / 8) * spec.channels;
+    if (SDL_SeekIO(io_, offset, SDL_IO_SEEK_SET) < 0) return false;
+    position = frame;
+    return true;
+}
+
+int WavDecoder::Read(float* out, int frames) {
+    if (!io_) return 0;
+    if (frames > MUSIC_CHUNK_FRAMES) frames = MUSIC_CHUNK_FRAMES;
+    if (frames > totalFrames - position) frames = totalFrames - position;
+    if (frames <= 0) return 0;
+
+    const int bytesPerSample = bits_ / 8;
+    const int frameBytes = bytesPerSample * spec.channels;
+    const size_t got = SDL_ReadIO(io_, raw_, (size_t)frames * frameBytes);
+    frames = (int)(got / frameBytes);
+
+    const int samples = frames * spec.channels;
+    const Uint8* src = raw_;
+    for (int i = 0; i < samples; ++i, src += bytesPerSample) {
+        switch (bits_) {
+        case 8:  out[i] = ((int)src[0] - 128) / 128.0f; break;
+        case 16: out[i] = (Sint16)ReadLE16(src) / 32768.0f; break;
+        case 24: out[i] = (Sint32)(((Uint32)src[0] << 8) | ((Uint32)src[1] << 16) | ((Uint32)src[2] << 24)) / 2147483648.0f; break;
+        default:
+            if (isFloat_) { Uint32 u = ReadLE32(src); float f; memcpy(&f, &u, 4); out[i] = f; }
+            else out[i] = (Sint32)ReadLE32(src) / 2147483648.0f;
+            break;
+        }
+    }
+
+    position += frames;
+    return frames;
+}
+
+MusicDecoder* OpenMusicDecoder(const char* path) {
+    const char* ext = SDL_strrchr(path, '.');
+    MusicDecoder* decoder = nullptr;
+    if (ext != nullptr && SDL_strcasecmp(ext, ".ogg") == 0) decoder = new VorbisDecoder();
+    else decoder = new WavDecoder();
+
+    if (!decoder->Open(path)) {
+        delete decoder;
+        return nullptr;
+    }
+    return decoder;
+}
+
+//
+//--------------- MusicStream --------------------
+//
+
+bool MusicStream::Init(SDL_AudioDeviceID device, const SDL_AudioSpec& deviceSpec) {
+    if (stream_) return true;
+
+    // The input format is set per track in StartCurrent
+    stream_ = SDL_CreateAudioStream(nullptr, &deviceSpec);
+    if (!stream_) {
+        LOG("Music: SDL_CreateAudioStream failed: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetAudioStreamGetCallback(stream_, &MusicStream::GetCallback, this);
+    outChannels_ = deviceSpec.channels;
+
+    // Without a device the stream stays unbound and is pulled by Render
+    if (device != 0 && !SDL_BindAudioStream(device, stream_)) {
+        LOG("Music: SDL_BindAudioStream failed: %s", SDL_GetError());
+        SDL_DestroyAudioStream(stream_);
+        stream_ = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void MusicStream::Shutdown() {
+    // Destroying the stream unbinds it, the callback can't run afterwards
+    if (stream_) {
+        SDL_DestroyAudioStream(stream_);
+        stream_ = nullptr;
+    }
+
+    Command c;
+    while (commands_.Pop(c)) delete c.decoder;
+    delete current_;
+    current_ = nullptr;
+    delete pending_;
+    pending_ = nullptr;
+    fade_ = Fade::NONE;
+    CollectRetired();
+}
+
+bool MusicStream::Play(MusicDecoder* decoder, float fadeTime) {
+    if (!stream_ || !decoder) {
+        delete decoder;
+        return false;
+    }
+
+    Command c{};
+    c.type = CommandType::PLAY;
+    c.decoder = decoder;
+    c.value = fadeTime;
+    if (!commands_.Push(c)) {
+        delete decoder;
+        return false;
+    }
+    return true;
+}
+
+void MusicStream::Stop(float fadeTime) {
+    Command c{};
+    c.type = CommandType::STOP;
+    c.value = fadeTime;
+    if (stream_) commands_.Push(c);
+}
+
+void MusicStream::SetVolume(float volume) {
+    Command c{};
+    c.type = CommandType::SET_VOLUME;
+    c.value = volume;
+    if (stream_) commands_.Push(c);
+}
+
+void MusicStream::SetLoopPoints(int startFrame, int endFrame) {
+    Command c{};
+    c.type = CommandType::SET_LOOP;
+    c.loopStart = startFrame;
+    c.loopEnd = endFrame;
+    if (stream_) commands_.Push(c);
+}
+
+int MusicStream::GetQueuedFrames() {
+    int channels = SDL_GetAtomicInt(&channels_);
+    if (!stream_ || channels <= 0) return 0;
+    return SDL_GetAudioStreamQueued(stream_) / (int)(sizeof(float) * channels);
+}
+
+int MusicStream::Render(float* out, int frames) {
+    if (!stream_) return 0;
+
+    // Runs the get callback on the calling thread
+    const int frameBytes = (int)sizeof(float) * outChannels_;
+    int bytes = SDL_GetAudioStreamData(stream_, out, frames * frameBytes);
+    return bytes > 0 ? bytes / frameBytes : 0;
+}
+
+void MusicStream::CollectRetired() {
+    MusicDecoder* decoder = nullptr;
+    while (retired_.Pop(decoder)) delete decoder;
+}
+
+// Audio thread: closing files is left to the game thread
+void MusicStream::Retire(MusicDecoder* decoder) {
+    if (decoder == nullptr) return;
+    if (!retired_.Push(decoder)) delete decoder; // queue full, close it here rather than leak
+}
+
+void MusicStream::ProcessCommands() {
+    Command c;
+    while (commands_.Pop(c)) {
+        switch (c.type)
+        {
+        case CommandType::PLAY:
+            if (current_ == nullptr) {
+                current_ = c.decoder;
+                StartCurrent(c.value);
+            }
+            else {
+                Retire(pending_);
+                pending_ = c.decoder;
+                pendingFadeTime_ = c.value;
+                StartFade(Fade::OUT_TO_NEXT, c.value, current_->spec.freq);
+            }
+            break;
+        case CommandType::STOP:
+            Retire(pending_);
+            pending_ = nullptr;
+            if (current_ != nullptr) {
+                if (c.value > 0.0f) {
+                    StartFade(Fade::OUT_TO_STOP, c.value, current_->spec.freq);
+                }
+                else {
+                    Retire(current_);
+                    current_ = nullptr;
+                    fade_ = Fade::NONE;
+                }
+            }
+            break;
+        case CommandType::SET_VOLUME:
+            volume_ = c.value;
+            break;
+        case CommandType::SET_LOOP:
+            if (current_ != nullptr && c.loopStart >= 0 && c.loopEnd > c.loopStart && c.loopEnd <= current_->totalFrames) {
+                current_->loopStart = c.loopStart;
+                current_->loopEnd = c.loopEnd;
+            }
+            break;
+        }
+    }
+}
+
+// Audio thread
+void MusicStream::StartCurrent(float fadeTime) {
+    SDL_SetAudioStreamFormat(stream_, &current_->spec, nullptr);
+    SDL_SetAtomicInt(&channels_, current_->spec.channels);
+    fadeGain_ = 0.0f;
+    StartFade(Fade::IN, fadeTime, current_->spec.freq);
+}
+
+// Audio thread
+void MusicStream::StartFade(Fade fade, float seconds, int freq) {
+    fade_ = fade;
+    if (seconds <= 0.0f || freq <= 0) {
+        // Instant: the next chunk jumps to the target gain
+        fadeStep_ = fade == Fade::IN ? 1.0f : -1.0f;
+        return;
+    }
+    const float step = 1.0f / (seconds * freq);
+    fadeStep_ = fade == Fade::IN ? step : -step;
+}
+
+// Runs on the SDL audio thread with the stream locked
+void SDLCALL MusicStream::GetCallback(void* userdata, SDL_AudioStream* stream, int additional_amount, int /*total_amount*/) {
+    MusicStream* music = (MusicStream*)userdata;
+    music->ProcessCommands();
+    music->Fill(stream, additional_amount);
+}
+
+void MusicStream::Fill(SDL_AudioStream* stream, int bytes) {
+    while (bytes > 0 && current_ != nullptr) {
+        const int channels = current_->spec.channels;
+        const int frameBytes = (int)sizeof(float) * channels;
+
+        int frames = bytes / frameBytes;
+        if (frames <= 0) frames = 1;
+        if (frames > MUSIC_CHUNK_FRAMES) frames = MUSIC_CHUNK_FRAMES;
+
+        int got = ReadLooping(buffer_, frames);
+        if (got <= 0) {
+            // Unreadable track, drop it
+            Retire(current_);
+            current_ = nullptr;
+            break;
+        }
+
+        ApplyGain(buffer_, got, channels);
+        SDL_PutAudioStreamData(stream, buffer_, got * frameBytes);
+        bytes -= got * frameBytes;
+
+        // Fade out finished: stop or continue with the pending track
+        if ((fade_ == Fade::OUT_TO_NEXT || fade_ == Fade::OUT_TO_STOP) && fadeGain_ <= 0.0f) {
+            Retire(current_);
+            current_ = nullptr;
+            fade_ = Fade::NONE;
+            if (pending_ != nullptr) {
+                current_ = pending_;
+                pending_ = nullptr;
+                StartCurrent(pendingFadeTime_);
+            }
+        }
+    }
+}
+
+int MusicStream::ReadLooping(float* out, int frames) {
+    int done = 0;
+    int emptyReads = 0;
+    while (done < frames && emptyReads < 2) {
+        const int end = current_->loopEnd > 0 ? current_->loopEnd : current_->totalFrames;
+        int count = frames - done;
+        if (count > end - current_->position) count = end - current_->position;
+
+        int got = count > 0 ? current_->Read(out + (size_t)done * current_->spec.channels, count) : 0;
+        done += got;
+
+        // End of the loop region: jump back without a gap
+        if (got < count || current_->position >= end) {
+            current_->Seek(current_->loopStart);
+        }
+        emptyReads = got == 0 ? emptyReads + 1 : 0;
+    }
+    return done;
+}
+
+void MusicStream::ApplyGain(float* samples, int frames, int channels) {
+    if (fade_ == Fade::NONE) {
+        if (volume_ == 1.0f) return;
+        for (int i = 0; i < frames * channels; ++i) samples[i] *= volume_;
+        return;
+    }
+
+    for (int f = 0; f < frames; ++f) {
+        fadeGain_ += fadeStep_;
+        if (fadeGain_ >= 1.0f) fadeGain_ = 1.0f;
+        if (fadeGain_ <= 0.0f) fadeGain_ = 0.0f;
+
+        const float gain = fadeGain_ * volume_;
+        float* frame = samples + (size_t)f * channels;
+        for (int c = 0; c < channels; ++c) frame[c] *= gain;
+    }
+
+    if (fade_ == Fade::IN && fadeGain_ >= 1.0f) fade_ = Fade::NONE;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include "SpscQueue.h"
+
+#define MUSIC_CHUNK_FRAMES 4096   // frames decoded per read
+#define MUSIC_MAX_CHANNELS 8
+#define MUSIC_QUEUE_SIZE 16
+
+struct stb_vorbis;
+
+// Source of interleaved float32 frames, read chunk by chunk on the audio thread
+class MusicDecoder
+{
+public:
+
+    virtual ~MusicDecoder() {}
+
+    virtual bool Open(const char* path) = 0;
+    virtual void Close() = 0;
+
+    // Returns the frames written to 'out', 0 at the end of the data
+    virtual int  Read(float* out, int frames) = 0;
+    virtual bool Seek(int frame) = 0;
+
+    SDL_AudioSpec spec{};  // format is always SDL_AUDIO_F32
+    int totalFrames{ 0 };
+    int position{ 0 };     // next frame to read
+
+    // Loop region in frames, loopEnd is exclusive (0 = end of the data)
+    int loopStart{ 0 };
+    int loopEnd{ 0 };
+};
+
+// RIFF/WAVE reader: PCM 8/16/24/32 bits and float32, loop points from the 'smpl' chunk
+class WavDecoder : public MusicDecoder
+{
+public:
+
+    ~WavDecoder();
+
+    bool Open(const char* path) override;
+    void Close() override;
+    int  Read(float* out, int frames) override;
+    bool Seek(int frame) override;
+
+private:
+
+    SDL_IOStream* io_{ nullptr };
+    Sint64 dataOffset_{ 0 };
+    int bits_{ 0 };
+    bool isFloat_{ false };
+    Uint8 raw_[MUSIC_CHUNK_FRAMES * MUSIC_MAX_CHANNELS * 4];
+};
+
+// Ogg Vorbis reader (stb_vorbis), loop points from the LOOPSTART / LOOPLENGTH comments
+class VorbisDecoder : public MusicDecoder
+{
+public:
+
+    ~VorbisDecoder();
+
+    bool Open(const char* path) override;
+    void Close() override;
+    int  Read(float* out, int frames) override;
+    bool Seek(int frame) override;
+
+private:
+
+    stb_vorbis* vorbis_{ nullptr };
+};
+
+// Picks the decoder from the file extension (.ogg or .wav), returns nullptr if it can't be opened
+MusicDecoder* OpenMusicDecoder(const char* path);
+
+// Streams one music track into its own device stream, with looping and fades.
+// The game thread posts commands, the decoders are owned by the audio thread.
+class MusicStream
+{
+public:
+
+    bool Init(SDL_AudioDeviceID device, const SDL_AudioSpec& deviceSpec);
+    void Shutdown();
+
+    // Takes ownership of an opened decoder. Fades out the current track (if any)
+    // and fades the new one in, each over fadeTime seconds
+    bool Play(MusicDecoder* decoder, float fadeTime);
+    void Stop(float fadeTime);
+
+    void SetVolume(float volume);
+
+    // Override the loop region of the current track (frames, end exclusive)
+    void SetLoopPoints(int startFrame, int endFrame);
+
+    // Delete the decoders the audio thread is done with, call from the game thread
+    void CollectRetired();
+
+    // Offline backend (Init with device 0): pull up to 'frames' frames at the output format,
+    // returns the frames written (0 when nothing is playing)
+    int Render(float* out, int frames);
+
+    // Instrumentation: frames of the current track waiting in the stream
+    int GetQueuedFrames();
+
+private:
+
+    enum class Fade {
+        NONE,
+        IN,
+        OUT_TO_NEXT,  // switch to pending_ when silent
+        OUT_TO_STOP
+    };
+
+    enum class CommandType {
+        PLAY,
+        STOP,
+        SET_VOLUME,
+        SET_LOOP
+    };
+
+    struct Command {
+        CommandType type;
+        MusicDecoder* decoder;
+        float value;          // fade time or volume
+        int loopStart;
+        int loopEnd;
+    };
+
+    static void SDLCALL GetCallback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount);
+    void ProcessCommands();
+    void Retire(MusicDecoder* decoder);
+    void Fill(SDL_AudioStream* stream, int bytes);
+    int  ReadLooping(float* out, int frames);
+    void ApplyGain(float* samples, int frames, int channels);
+    void StartFade(Fade fade, float seconds, int freq);
+    void StartCurrent(float fadeTime);
+
+    SDL_AudioStream* stream_{ nullptr };
+
+    SpscQueue<Command, MUSIC_QUEUE_SIZE> commands_;        // game -> audio
+    SpscQueue<MusicDecoder*, MUSIC_QUEUE_SIZE> retired_;   // audio -> game
+
+    // Audio thread state
+    MusicDecoder* current_{ nullptr };
+    MusicDecoder* pending_{ nullptr };
+    float pendingFadeTime_{ 0.0f };
+    Fade fade_{ Fade::NONE };
+    float fadeGain_{ 1.0f };
+    float fadeStep_{ 0.0f };  // gain change per frame
+    float volume_{ 1.0f };
+    SDL_AtomicInt channels_{};  // of the current track, read by GetQueuedFrames
+    int outChannels_{ 2 };      // of the stream output
+
+    float buffer_[MUSIC_CHUNK_FRAMES * MUSIC_MAX_CHANNELS];
+};
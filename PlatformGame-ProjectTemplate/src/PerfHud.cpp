@@ -0,0 +1,140 @@
+#include "PerfHud.h"
+
+#define HUD_X 8.0f
+#define HUD_Y 8.0f
+#define HUD_WIDTH 412.0f
+#define HUD_LINE 10.0f                // 8 px glyphs + spacing
+#define HUD_GRAPH_HEIGHT 60.0f
+#define HUD_BAR_X (HUD_X + 208.0f)   // after the 25 glyphs of a module row
+#define HUD_BAR_PX_PER_MS 12.0f
+#define HUD_FRAME_BUDGET_MS (1000.0f / 60.0f)
+
+void PerfHud::SetModuleName(int index, const char* name)
+{
+	if (index < 0 || index >= PERF_HUD_MAX_MODULES)
+		return;
+
+	SDL_strlcpy(moduleNames[index], name, PERF_HUD_NAME_SIZE);
+	if (index >= moduleCount)
+		moduleCount = index + 1;
+}
+
+void PerfHud::AddFrame(float frameMs, const double* moduleMs, int count)
+{
+	frameTimes.Add(frameMs);
+
+	if (count > moduleCount)
+		count = moduleCount;
+	for (int i = 0; i < count; ++i)
+	{
+		float ms = (float)moduleMs[i];
+		moduleAverage[i] = moduleAverage[i] * 0.9f + ms * 0.1f;
+		if (ms > modulePeak[i])
+			modulePeak[i] = ms;
+	}
+}
+
+bool PerfHud::NeedsRefresh() const
+{
+	return !hasStats || SDL_GetTicks() - lastRefresh >= PERF_HUD_TEXT_REFRESH_MS;
+}
+
+void PerfHud::SetStats(const PerfHudStats& newStats)
+{
+	stats = newStats;
+	hasStats = true;
+	lastRefresh = SDL_GetTicks();
+	FormatText();
+}
+
+void PerfHud::FormatText()
+{
+	SDL_snprintf(frameLine, sizeof(frameLine), "FPS %d  avg %.1f  last %.2f ms  %dx%d",
+		stats.fps, stats.averageFps, frameTimes.Count() > 0 ? frameTimes.Get(0) : 0.0f, stats.internalWidth, stats.internalHeight);
+
+	SDL_snprintf(percentileLine, sizeof(percentileLine), "p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+		frameTimes.Percentile(50.0f), frameTimes.Percentile(95.0f), frameTimes.Percentile(99.0f), frameTimes.Max());
+
+	SDL_snprintf(counterLine, sizeof(counterLine), "draws %d  bodies %d  mem %.1f MB  heap %.1f MB",
+		stats.drawCalls, stats.bodies, stats.trackedBytes / (1024.0 * 1024.0), stats.heapBytes / (1024.0 * 1024.0));
+
+	SDL_snprintf(renderLine, sizeof(renderLine), "sprites %d  tex %d  state %d  prims %d  culled %d",
+		stats.sprites, stats.textureSwitches, stats.stateChanges, stats.primitives, stats.culled);
+
+	for (int i = 0; i < moduleCount; ++i)
+	{
+		SDL_snprintf(moduleLines[i], sizeof(moduleLines[i]), "%-13s %5.2f %5.2f", moduleNames[i], moduleAverage[i], modulePeak[i]);
+		moduleBars[i] = moduleAverage[i];
+		modulePeak[i] = 0.0f;
+	}
+}
+
+void PerfHud::Draw(SDL_Renderer* renderer)
+{
+	if (!visible || renderer == nullptr)
+		return;
+
+	float y = HUD_Y;
+	const float height = HUD_LINE * (5 + moduleCount) + HUD_GRAPH_HEIGHT + 8.0f;
+
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+	SDL_FRect panel = { HUD_X - 4.0f, HUD_Y - 4.0f, HUD_WIDTH, height };
+	SDL_RenderFillRect(renderer, &panel);
+
+	SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+	SDL_RenderDebugText(renderer, HUD_X, y, frameLine);
+	y += HUD_LINE;
+	SDL_RenderDebugText(renderer, HUD_X, y, percentileLine);
+	y += HUD_LINE;
+	SDL_RenderDebugText(renderer, HUD_X, y, counterLine);
+	y += HUD_LINE;
+	SDL_RenderDebugText(renderer, HUD_X, y, renderLine);
+	y += HUD_LINE + 2.0f;
+
+	// Frame graph, newest on the right, with the 60 and 30 FPS budgets
+	const float graphWidth = HUD_WIDTH - 8.0f;
+	const float graphBottom = y + HUD_GRAPH_HEIGHT;
+	const float pxPerMs = HUD_GRAPH_HEIGHT / PERF_HUD_GRAPH_MAX_MS;
+	const float step = graphWidth / ROLLING_STATS_WINDOW;
+
+	SDL_SetRenderDrawColor(renderer, 80, 80, 80, 255);
+	SDL_RenderLine(renderer, HUD_X, graphBottom - HUD_FRAME_BUDGET_MS * pxPerMs, HUD_X + graphWidth, graphBottom - HUD_FRAME_BUDGET_MS * pxPerMs);
+	SDL_RenderLine(renderer, HUD_X, graphBottom - 2.0f * HUD_FRAME_BUDGET_MS * pxPerMs, HUD_X + graphWidth, graphBottom - 2.0f * HUD_FRAME_BUDGET_MS * pxPerMs);
+
+	SDL_FPoint points[ROLLING_STATS_WINDOW];
+	int count = frameTimes.Count();
+	for (int i = 0; i < count; ++i)
+	{
+		float ms = SDL_min(frameTimes.Get(i), PERF_HUD_GRAPH_MAX_MS);
+		points[i].x = HUD_X + graphWidth - i * step;
+		points[i].y = graphBottom - ms * pxPerMs;
+	}
+	SDL_SetRenderDrawColor(renderer, 80, 220, 80, 255);
+	if (count > 1)
+		SDL_RenderLines(renderer, points, count);
+
+	// Hitches: frames over two budgets get a red bar so they stay visible while they scroll
+	SDL_SetRenderDrawColor(renderer, 230, 60, 60, 255);
+	for (int i = 0; i < count; ++i)
+	{
+		if (frameTimes.Get(i) > 2.0f * HUD_FRAME_BUDGET_MS)
+			SDL_RenderLine(renderer, points[i].x, graphBottom, points[i].x, points[i].y);
+	}
+	y = graphBottom + 6.0f;
+
+	// Module bars: smoothed ms, peak since the last refresh in the text
+	for (int i = 0; i < moduleCount; ++i)
+	{
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+		SDL_RenderDebugText(renderer, HUD_X, y, moduleLines[i]);
+
+		SDL_FRect bar = { HUD_BAR_X, y, SDL_min(moduleBars[i] * HUD_BAR_PX_PER_MS, HUD_X + HUD_WIDTH - 8.0f - HUD_BAR_X), 7.0f };
+		if (moduleBars[i] > HUD_FRAME_BUDGET_MS * 0.5f)
+			SDL_SetRenderDrawColor(renderer, 230, 60, 60, 255);
+		else
+			SDL_SetRenderDrawColor(renderer, 90, 160, 230, 255);
+		SDL_RenderFillRect(renderer, &bar);
+		y += HUD_LINE;
+	}
+}
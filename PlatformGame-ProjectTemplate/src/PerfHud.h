@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Stats.h"
+#include <SDL3/SDL.h>
+
+#define PERF_HUD_MAX_MODULES 16
+#define PERF_HUD_NAME_SIZE 16
+#define PERF_HUD_LINE_SIZE 96
+#define PERF_HUD_TEXT_REFRESH_MS 250   // the text is formatted 4 times per second, drawn every frame
+#define PERF_HUD_GRAPH_MAX_MS 50.0f    // top of the frame graph
+
+// Counters shown by the HUD, gathered by the engine when the text is refreshed
+struct PerfHudStats
+{
+	int fps = 0;
+	float averageFps = 0.0f;
+	int drawCalls = 0;
+	int sprites = 0;
+	int textureSwitches = 0;
+	int stateChanges = 0;
+	int primitives = 0;
+	int culled = 0;
+	int internalWidth = 0;        // size the world is drawn at
+	int internalHeight = 0;
+	int bodies = 0;
+	long long trackedBytes = 0;   // MemoryTracker, subsystem reports
+	long long heapBytes = 0;      // MemoryTracker, operator new (PLATFORMGAME_TRACK_HEAP)
+};
+
+// On-screen performance overlay: frame time graph, percentiles, per-module bars and counters.
+// Screen space, drawn with the SDL debug font (one cached glyph texture). Nothing is allocated:
+// the text goes to fixed buffers and is only formatted every PERF_HUD_TEXT_REFRESH_MS.
+class PerfHud
+{
+public:
+
+	void Toggle() { visible = !visible; }
+	void SetVisible(bool show) { visible = show; }
+	bool IsVisible() const { return visible; }
+
+	void SetModuleName(int index, const char* name);
+
+	// Call once per frame while visible: whole frame time and the time of each module (ms)
+	void AddFrame(float frameMs, const double* moduleMs, int moduleCount);
+
+	// The text is due: gather the stats and pass them with SetStats before Draw
+	bool NeedsRefresh() const;
+	void SetStats(const PerfHudStats& stats);
+
+	void Draw(SDL_Renderer* renderer);
+
+private:
+
+	void FormatText();
+
+	bool visible = false;
+
+	RollingStats frameTimes;
+
+	int moduleCount = 0;
+	char moduleNames[PERF_HUD_MAX_MODULES][PERF_HUD_NAME_SIZE] = {};
+	float moduleAverage[PERF_HUD_MAX_MODULES] = {};   // smoothed ms
+	float modulePeak[PERF_HUD_MAX_MODULES] = {};      // max since the last text refresh
+
+	PerfHudStats stats;
+	Uint64 lastRefresh = 0;
+	bool hasStats = false;
+
+	char frameLine[PERF_HUD_LINE_SIZE] = {};
+	char percentileLine[PERF_HUD_LINE_SIZE] = {};
+	char counterLine[PERF_HUD_LINE_SIZE] = {};
+	char renderLine[PERF_HUD_LINE_SIZE] = {};
+	char moduleLines[PERF_HUD_MAX_MODULES][PERF_HUD_LINE_SIZE] = {};
+	float moduleBars[PERF_HUD_MAX_MODULES] = {};       // ms shown by the bars, refreshed with the text
+};
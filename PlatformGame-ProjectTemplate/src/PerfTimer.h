@@ -1,5 +1,5 @@
 #pragma once
-#include <SDL3\SDL_timer.h>
+#include <SDL3/SDL_timer.h>
 
 class PerfTimer
 {
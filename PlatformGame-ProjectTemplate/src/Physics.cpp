@@ -13,6 +13,7 @@
 Physics::Physics() : Module()
 {
     world = b2_nullWorldId;
+    memTag = MemTag::PHYSICS;
     debug = false; // toggle with F9
 }
 
@@ -32,6 +33,9 @@ bool Physics::Start()
     wdef.gravity.y = -GRAVITY_Y;
     world = b2CreateWorld(&wdef);
 
+    // One-way platforms decide per contact whether they block
+    b2World_SetPreSolveCallback(world, &Physics::PreSolveCb, this);
+
     return true;
 }
 
@@ -179,6 +183,65 @@ PhysBody* Physics::CreateChain(int x, int y, int* points, int size, bodyType typ
     return pbody;
 }
 
+PhysBody* Physics::CreateStaticBoxes(const SDL_Rect* rects, int count, ColliderType type)
+{
+    b2BodyDef def = b2DefaultBodyDef();
+    def.type = b2_staticBody;
+
+    b2BodyId b = b2CreateBody(world, &def);
+
+    b2ShapeDef sdef = b2DefaultShapeDef();
+    sdef.enableContactEvents = true;
+    sdef.enableSensorEvents = true;
+    sdef.enablePreSolveEvents = (type == ColliderType::PLATFORM_ONEWAY);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const SDL_Rect& r = rects[i];
+        b2Vec2 center = { PIXEL_TO_METERS(r.x + r.w * 0.5f), PIXEL_TO_METERS(r.y + r.h * 0.5f) };
+        b2Polygon box = b2MakeOffsetBox(PIXEL_TO_METERS(r.w) * 0.5f, PIXEL_TO_METERS(r.h) * 0.5f, center, b2Rot_identity);
+        b2CreatePolygonShape(b, &sdef, &box);
+    }
+
+    PhysBody* pbody = Engine::GetInstance().GetLevelArena().New<PhysBody>();
+    pbody->body = b;
+    pbody->ctype = type;
+    b2Body_SetUserData(b, ToUserData(pbody));
+    return pbody;
+}
+
+bool Physics::IsOneWayShape(b2ShapeId shape)
+{
+    PhysBody* pb = BodyToPhys(b2Shape_GetBody(shape));
+    return pb != nullptr && pb->ctype == ColliderType::PLATFORM_ONEWAY;
+}
+
+// Called from the Box2D workers: only read state here, never create or destroy anything
+bool Physics::PreSolveCb(b2ShapeId shapeA, b2ShapeId shapeB, b2Manifold* manifold, void*)
+{
+    // The manifold normal points from A to B, flip it so it points from the platform to the other body
+    float sign;
+    b2ShapeId platform, other;
+    if (IsOneWayShape(shapeA)) { sign = 1.0f; platform = shapeA; other = shapeB; }
+    else if (IsOneWayShape(shapeB)) { sign = -1.0f; platform = shapeB; other = shapeA; }
+    else return true;
+
+    // The other body has to be above the platform (Y grows downwards)
+    b2Vec2 normal = { sign * manifold->normal.x, sign * manifold->normal.y };
+    if (normal.y > -0.7f) return false;
+
+    // Coming from below: it already sank deeper than the slop into the platform
+    for (int i = 0; i < manifold->pointCount; ++i) {
+        if (manifold->points[i].separation < -PIXEL_TO_METERS(ONEWAY_PENETRATION_SLOP)) return false;
+    }
+
+    // Moving away from the top face (jumping up through it)
+    b2Vec2 vOther = b2Body_GetLinearVelocity(b2Shape_GetBody(other));
+    b2Vec2 vPlatform = b2Body_GetLinearVelocity(b2Shape_GetBody(platform));
+    float relative = (vOther.x - vPlatform.x) * normal.x + (vOther.y - vPlatform.y) * normal.y;
+    return relative <= ONEWAY_SEPARATION_SPEED;
+}
+
 // 
 bool Physics::PostUpdate()
 {
@@ -193,6 +256,7 @@ bool Physics::PostUpdate()
     {
         if (B2_IS_NULL(world) == false)
         {
+            RenderTagScope renderTag(*Engine::GetInstance().render, RenderTag::DEBUG);
             b2DebugDraw dd = {};
             dd.context = this;
 
@@ -280,7 +344,7 @@ void Physics::EndContact(b2ShapeId shapeA, b2ShapeId shapeB)
 void Physics::DeletePhysBody(PhysBody* physBody)
 {
 	if (B2_IS_NULL(world)) return; // world already destroyed
-    if (physBody && !B2_IS_NULL(physBody->body) && physBody->listener->active)
+    if (physBody && !B2_IS_NULL(physBody->body) && (physBody->listener == nullptr || physBody->listener->active))
     {
         // Dont change contact/sensor flags here (can mismatch event buffers).
         // Just clear user data so late events wont dereference a dangling PhysBody*.
@@ -291,6 +355,28 @@ void Physics::DeletePhysBody(PhysBody* physBody)
 
 
 
+void Physics::GetMemoryUsage(int64_t& bytes, int& bodies) const
+{
+    bytes = 0;
+    bodies = 0;
+    if (B2_IS_NULL(world)) return;
+
+    b2Counters counters = b2World_GetCounters(world);
+    bytes = counters.byteCount;
+    bodies = counters.bodyCount;
+}
+
+void Physics::DestroyPhysBodyNow(PhysBody* physBody)
+{
+    if (physBody == nullptr) return;
+
+    // The whole world (and its bodies) is gone after CleanUp
+    if (!B2_IS_NULL(world) && b2Body_IsValid(physBody->body)) {
+        b2DestroyBody(physBody->body);
+    }
+    physBody->body = b2_nullBodyId;
+}
+
 bool Physics::IsPendingToDelete(PhysBody* physBody) {
     bool pendingToDelete = false;
     for (PhysBody* _physBody : bodiesToDelete) {
@@ -350,6 +436,150 @@ void Physics::ApplyLinearImpulseToCenter(PhysBody* p, float ix, float iy, bool w
     b2Body_ApplyLinearImpulseToCenter(p->body, imp, wake);
 }
 
+// --- Body state helpers
+void Physics::SetBodyType(PhysBody* p, bodyType type) const
+{
+    b2Body_SetType(p->body, ToB2Type(type));
+}
+
+void Physics::SetGravityScale(PhysBody* p, float scale) const
+{
+    b2Body_SetGravityScale(p->body, scale);
+}
+
+// --- Batched queries
+
+namespace {
+    struct ClosestHitContext
+    {
+        unsigned int mask;
+        QueryHit* hit;
+    };
+
+    struct OverlapContext
+    {
+        unsigned int mask;
+        PhysBody** bodies;
+        int capacity;
+        int count;
+    };
+
+    void ClearHit(QueryHit& hit)
+    {
+        hit.hit = false;
+        hit.body = nullptr;
+        hit.x = hit.y = 0.0f;
+        hit.normalX = hit.normalY = 0.0f;
+        hit.fraction = 1.0f;
+    }
+}
+
+bool Physics::MatchesMask(PhysBody* pb, unsigned int colliderMask)
+{
+    return pb != nullptr && (COLLIDER_MASK(pb->ctype) & colliderMask) != 0;
+}
+
+float Physics::ClosestHitCb(b2ShapeId shape, b2Vec2 point, b2Vec2 normal, float fraction, void* ctx)
+{
+    ClosestHitContext* c = (ClosestHitContext*)ctx;
+    PhysBody* pb = BodyToPhys(b2Shape_GetBody(shape));
+    if (b2Shape_IsSensor(shape) || !MatchesMask(pb, c->mask)) return -1.0f; // ignore, keep going
+
+    QueryHit* hit = c->hit;
+    hit->hit = true;
+    hit->body = pb;
+    hit->x = PIXELS_PER_METER * point.x;
+    hit->y = PIXELS_PER_METER * point.y;
+    hit->normalX = normal.x;
+    hit->normalY = normal.y;
+    hit->fraction = fraction;
+    return fraction; // clip the ray, Box2D keeps looking for closer hits
+}
+
+bool Physics::OverlapCb(b2ShapeId shape, void* ctx)
+{
+    OverlapContext* c = (OverlapContext*)ctx;
+    PhysBody* pb = BodyToPhys(b2Shape_GetBody(shape));
+    if (!MatchesMask(pb, c->mask)) return true;
+
+    // Skip the other shapes of a body already reported
+    for (int i = 0; i < c->count; ++i) {
+        if (c->bodies[i] == pb) return true;
+    }
+
+    c->bodies[c->count++] = pb;
+    return c->count < c->capacity;
+}
+
+void Physics::CastRays(const RayQuery* rays, QueryHit* hits, int first, int count, unsigned int colliderMask) const
+{
+    const b2QueryFilter qf = b2DefaultQueryFilter();
+
+    for (int i = first; i < first + count; ++i)
+    {
+        const RayQuery& ray = rays[i];
+        ClearHit(hits[i]);
+
+        const b2Vec2 origin = { PIXEL_TO_METERS(ray.x1), PIXEL_TO_METERS(ray.y1) };
+        const b2Vec2 translation = { PIXEL_TO_METERS(ray.x2 - ray.x1), PIXEL_TO_METERS(ray.y2 - ray.y1) };
+
+        ClosestHitContext ctx = { colliderMask, &hits[i] };
+        b2World_CastRay(world, origin, translation, qf, &Physics::ClosestHitCb, &ctx);
+    }
+}
+
+void Physics::CastShapes(const ShapeCastQuery* casts, QueryHit* hits, int first, int count, unsigned int colliderMask) const
+{
+    const b2QueryFilter qf = b2DefaultQueryFilter();
+
+    for (int i = first; i < first + count; ++i)
+    {
+        const ShapeCastQuery& cast = casts[i];
+        ClearHit(hits[i]);
+
+        const b2Vec2 center = { PIXEL_TO_METERS(cast.x), PIXEL_TO_METERS(cast.y) };
+        b2ShapeProxy proxy;
+        if (cast.radius > 0.0f)
+        {
+            proxy = b2MakeProxy(&center, 1, PIXEL_TO_METERS(cast.radius));
+        }
+        else
+        {
+            const float hw = PIXEL_TO_METERS(cast.halfW);
+            const float hh = PIXEL_TO_METERS(cast.halfH);
+            const b2Vec2 corners[4] = {
+                { center.x - hw, center.y - hh }, { center.x + hw, center.y - hh },
+                { center.x + hw, center.y + hh }, { center.x - hw, center.y + hh }
+            };
+            proxy = b2MakeProxy(corners, 4, 0.0f);
+        }
+
+        const b2Vec2 translation = { PIXEL_TO_METERS(cast.dx), PIXEL_TO_METERS(cast.dy) };
+        ClosestHitContext ctx = { colliderMask, &hits[i] };
+        b2World_CastShape(world, &proxy, translation, qf, &Physics::ClosestHitCb, &ctx);
+    }
+}
+
+void Physics::OverlapAABBs(const AABBQuery* boxes, PhysBody** bodies, int maxPerQuery, int* counts, int first, int count, unsigned int colliderMask) const
+{
+    const b2QueryFilter qf = b2DefaultQueryFilter();
+
+    for (int i = first; i < first + count; ++i)
+    {
+        const AABBQuery& box = boxes[i];
+        counts[i] = 0;
+        if (maxPerQuery <= 0) continue;
+
+        b2AABB aabb;
+        aabb.lowerBound = { PIXEL_TO_METERS(box.x), PIXEL_TO_METERS(box.y) };
+        aabb.upperBound = { PIXEL_TO_METERS(box.x + box.w), PIXEL_TO_METERS(box.y + box.h) };
+
+        OverlapContext ctx = { colliderMask, bodies + (size_t)i * maxPerQuery, maxPerQuery, 0 };
+        b2World_OverlapAABB(world, aabb, qf, &Physics::OverlapCb, &ctx);
+        counts[i] = ctx.count;
+    }
+}
+
 //
 //--------------- PhysBody --------------------
 //
@@ -373,25 +603,35 @@ float PhysBody::GetRotation() const
     return RADTODEG * b2Rot_GetAngle(xf.q);
 }
 
+namespace {
+    struct ContainsContext
+    {
+        b2BodyId body;
+        b2Vec2 point;
+        bool inside;
+    };
+
+    bool ContainsCb(b2ShapeId shape, void* ctx)
+    {
+        ContainsContext* c = (ContainsContext*)ctx;
+        if (!B2_ID_EQUALS(b2Shape_GetBody(shape), c->body)) return true;
+
+        c->inside = b2Shape_TestPoint(shape, c->point);
+        return !c->inside;
+    }
+}
+
 bool PhysBody::Contains(int x, int y) const
 {
     // World-space point in meters
     const b2Vec2 p = { PIXEL_TO_METERS(x), PIXEL_TO_METERS(y) };
 
-    // Get all shapes attached to this body
-    const int shapeCount = b2Body_GetShapeCount(body);
-    if (shapeCount == 0) return false;
-
-    std::vector<b2ShapeId> shapes(shapeCount);
-    b2Body_GetShapes(body, shapes.data(), shapeCount);
-
-    // Test point against each shape
-    for (int i = 0; i < shapeCount; ++i)
-    {
-        if (b2Shape_TestPoint(shapes[i], p))
-            return true;
-    }
-    return false;
+    // Only the shapes of the broadphase around the point are tested, whatever the shape count
+    // of the body (level bodies have one per collider)
+    b2AABB aabb = { p, p };
+    ContainsContext ctx = { body, p, false };
+    b2World_OverlapAABB(b2Body_GetWorld(body), aabb, b2DefaultQueryFilter(), &ContainsCb, &ctx);
+    return ctx.inside;
 }
 
 int PhysBody::RayCast(int x1, int y1, int x2, int y2, float& normal_x, float& normal_y) const
@@ -455,7 +695,7 @@ void Physics::DrawSolidPolygonCb(b2Transform xf, const b2Vec2* v, int n,
     float /*radius*/, b2HexColor color, void* ctx)
 {
     // Transform local verts to world and reuse wireframe draw
-    std::vector<b2Vec2> world(n);
+    FrameVector<b2Vec2> world(n, FrameAllocator<b2Vec2>(Engine::GetInstance().GetFrameArena()));
     for (int i = 0; i < n; ++i) world[i] = b2TransformPoint(xf, v[i]);
     DrawPolygonCb(world.data(), n, color, ctx);
 }
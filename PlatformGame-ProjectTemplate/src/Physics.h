@@ -14,6 +14,10 @@
 #define METERS_TO_PIXELS(m) ((int) floor(PIXELS_PER_METER * (m)))
 #define PIXEL_TO_METERS(p)  ((float) METER_PER_PIXEL * (p))
 
+// One-way platforms: penetration (pixels) and separating speed (m/s) still accepted as a landing
+#define ONEWAY_PENETRATION_SLOP 4
+#define ONEWAY_SEPARATION_SPEED 0.1f
+
 #define DEGTORAD 0.0174532925199432957f
 #define RADTODEG 57.295779513082320876f
 
@@ -34,7 +38,43 @@ enum class ColliderType {
     // ..
 };
 
-// Small class to return to other modules to track position and rotation of physics bodies
+// Collider type masks for the batched queries
+#define COLLIDER_MASK(type) (1u << (unsigned int)(type))
+#define COLLIDER_MASK_ALL   0xFFFFFFFFu
+
+// --- Batched query inputs / outputs (pixels, same space as the rest of the API)
+struct RayQuery
+{
+    float x1, y1;
+    float x2, y2;
+};
+
+struct ShapeCastQuery
+{
+    float x, y;            // start position of the shape center
+    float dx, dy;          // translation
+    float radius;          // > 0 casts a circle
+    float halfW, halfH;    // otherwise an axis aligned box
+};
+
+struct AABBQuery
+{
+    float x, y, w, h;
+};
+
+class PhysBody;
+
+struct QueryHit
+{
+    bool hit;
+    PhysBody* body;
+    float x, y;            // hit point
+    float normalX, normalY;
+    float fraction;        // along the ray / translation, 1 if nothing was hit
+};
+
+// Small class to return to other modules to track position and rotation of physics bodies.
+// Its helpers are for the main thread only (outside of the world step)
 class PhysBody
 {
 public:
@@ -73,12 +113,20 @@ public:
     PhysBody* CreateCircle(int x, int y, int radious, bodyType type);
     PhysBody* CreateRectangleSensor(int x, int y, int width, int height, bodyType type);
     PhysBody* CreateChain(int x, int y, int* points, int size, bodyType type);
+    // One static body with a box shape per rect (pixels), for the level colliders. The PhysBody
+    // lives in the level arena: destroy it with DestroyPhysBodyNow before the arena is reset
+    PhysBody* CreateStaticBoxes(const SDL_Rect* rects, int count, ColliderType type);
 
     // Invoked from our event processing
     void BeginContact(b2ShapeId shapeA, b2ShapeId shapeB);
     void EndContact(b2ShapeId shapeA, b2ShapeId shapeB);
 
     void DeletePhysBody(PhysBody* physBody);
+
+    // Box2D memory (its own allocator) and body count, 0 once the world is destroyed
+    void GetMemoryUsage(int64_t& bytes, int& bodies) const;
+    // Destroys the Box2D body right away, never during the world step. The PhysBody is not freed
+    void DestroyPhysBodyNow(PhysBody* physBody);
     bool IsPendingToDelete(PhysBody* physBody);
 
     // --- Velocity helpers (thin wrappers over Box2D 3.x C API)
@@ -94,6 +142,19 @@ public:
     // --- Impulse helper (handy for jumps/dashes)
     void   ApplyLinearImpulseToCenter(PhysBody* p, float ix, float iy, bool wake = true) const;
 
+    // --- Body state helpers. SetBodyType rebuilds contacts in Box2D, call it on state changes only
+    void   SetBodyType(PhysBody* p, bodyType type) const;
+    void   SetGravityScale(PhysBody* p, float scale) const;
+
+    // --- Batched queries. Each call handles the range [first, first + count) and only writes
+    // the outputs of that range, so disjoint ranges of one batch can run on different threads
+    // (never during the world step). Nothing is allocated per query.
+    void   CastRays(const RayQuery* rays, QueryHit* hits, int first, int count, unsigned int colliderMask) const;
+    void   CastShapes(const ShapeCastQuery* casts, QueryHit* hits, int first, int count, unsigned int colliderMask) const;
+    // bodies holds maxPerQuery slots per query (query i writes from bodies[i * maxPerQuery]),
+    // counts[i] receives the number of bodies found, extra overlaps are dropped
+    void   OverlapAABBs(const AABBQuery* boxes, PhysBody** bodies, int maxPerQuery, int* counts, int first, int count, unsigned int colliderMask) const;
+
 private:
     // helpers
     static b2BodyType ToB2Type(bodyType t);
@@ -101,6 +162,15 @@ private:
     static PhysBody* FromUserData(void* ud) { return (PhysBody*)ud; }
     static PhysBody* BodyToPhys(b2BodyId b) { return FromUserData(b2Body_GetUserData(b)); }
 
+    // Pre-solve hook, runs on the Box2D workers for shapes created with enablePreSolveEvents
+    static bool PreSolveCb(b2ShapeId shapeA, b2ShapeId shapeB, b2Manifold* manifold, void* ctx);
+    static bool IsOneWayShape(b2ShapeId shape);
+
+    // Batched query callbacks
+    static float ClosestHitCb(b2ShapeId shape, b2Vec2 point, b2Vec2 normal, float fraction, void* ctx);
+    static bool OverlapCb(b2ShapeId shape, void* ctx);
+    static bool MatchesMask(PhysBody* pb, unsigned int colliderMask);
+
     // --- Debug draw callbacks (Box2D 3.1 signatures)
     static void DrawSegmentCb(b2Vec2 p1, b2Vec2 p2, b2HexColor color, void* ctx);
     static void DrawPolygonCb(const b2Vec2* verts, int count, b2HexColor color, void* ctx);
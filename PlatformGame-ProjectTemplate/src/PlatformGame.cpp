@@ -9,6 +9,8 @@ int main(int argc, char* argv[]) {
 
 	LOG("Engine starting ...");
 
+	Engine::GetInstance().ParseCommandLine(argc, argv);
+
 	//Initializes the engine state
 	Engine::EngineState state = Engine::EngineState::CREATE;
 	int result = EXIT_FAILURE;
@@ -66,7 +66,7 @@ bool Player::Start() {
 	anims.SetCurrent("idle");
 
 	// Load texture using the path from config
-	texture = Engine::GetInstance().textures->Load(texturePath.c_str());
+	sprite = Engine::GetInstance().textures->LoadRegion(texturePath.c_str(), AtlasGroup::COMMON);
 
 	// L08 TODO 5: Add physics to the player - initialize physics body
 	pbody = Engine::GetInstance().physics->CreateCircle((int)position.getX(), (int)position.getY(), texW / 2, bodyType::DYNAMIC);
@@ -79,6 +79,7 @@ bool Player::Start() {
 
 	// Initialize audio effect using the path from config
 	pickCoinFxId = Engine::GetInstance().audio->LoadFx(pickCoinFxPath.c_str());
+	Engine::GetInstance().audio->SetFxLimit(pickCoinFxId, 2); // coin spam restarts instead of stacking
 
 	return true;
 }
@@ -86,6 +87,7 @@ bool Player::Start() {
 bool Player::Update(float dt)
 {
 	if (isDead) {
+		UpdateState();
 		respawnTimer -= dt;
 		if (respawnTimer <= 0.0f) {
 			Respawn();
@@ -94,9 +96,10 @@ bool Player::Update(float dt)
 	}
 
 	GetPhysicsValues();
+	UpdateState();
 
 	// Different movement logic for God Mode
-	if (godMode) {
+	if (state == PlayerState::GOD_MODE) {
 		MoveGodMode();
 	}
 	else {
@@ -120,7 +123,9 @@ bool Player::Update(float dt)
 
 		CheckDeath();
 	}
-	CheckCheckpoints();
+
+	// Single query per tick against the static trigger hash
+	Engine::GetInstance().map->triggers.Update(this, GetAABB());
 
 	Teleport();
 	ApplyPhysics();
@@ -202,8 +207,6 @@ void Player::Respawn() {
 void Player::GetPhysicsValues() {
 	velocity = Engine::GetInstance().physics->GetLinearVelocity(pbody);
 
-	lastYVelocity = velocity.y;
-
 	if (!isDashing) {
 		velocity = { 0.0f, velocity.y };
 	}
@@ -214,11 +217,11 @@ void Player::Move() {
 		return;
 	}
 
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_A) == KEY_REPEAT) {
+	if (Engine::GetInstance().input->GetAction(InputAction::LEFT).state == KEY_REPEAT) {
 		velocity.x = -speed;
 		anims.SetCurrent("move");
 	}
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_D) == KEY_REPEAT) {
+	if (Engine::GetInstance().input->GetAction(InputAction::RIGHT).state == KEY_REPEAT) {
 		velocity.x = speed;
 		anims.SetCurrent("move");
 	}
@@ -229,17 +232,17 @@ void Player::MoveGodMode() {
 
 	velocity = { 0.0f, 0.0f };
 
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_W) == KEY_REPEAT) {
+	if (Engine::GetInstance().input->GetAction(InputAction::UP).state == KEY_REPEAT) {
 		velocity.y = -godSpeed;
 	}
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_S) == KEY_REPEAT) {
+	if (Engine::GetInstance().input->GetAction(InputAction::DOWN).state == KEY_REPEAT) {
 		velocity.y = godSpeed;
 	}
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_A) == KEY_REPEAT) {
+	if (Engine::GetInstance().input->GetAction(InputAction::LEFT).state == KEY_REPEAT) {
 		velocity.x = -godSpeed;
 		anims.SetCurrent("move");
 	}
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_D) == KEY_REPEAT) {
+	if (Engine::GetInstance().input->GetAction(InputAction::RIGHT).state == KEY_REPEAT) {
 		velocity.x = godSpeed;
 		anims.SetCurrent("move");
 	}
@@ -250,7 +253,7 @@ void Player::MoveGodMode() {
 }
 
 void Player::Jump() {
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_SPACE) == KEY_DOWN && !isJumping) {
+	if (Engine::GetInstance().input->GetAction(InputAction::JUMP).state == KEY_DOWN && !isJumping) {
 		Engine::GetInstance().physics->ApplyLinearImpulseToCenter(pbody, 0.0f, -jumpForce, true);
 		anims.SetCurrent("jump");
 		isJumping = true;
@@ -259,14 +262,14 @@ void Player::Jump() {
 	}
 
 	if (isJumping && !spaceWasReleased && !hasDoubleJump &&
-		Engine::GetInstance().input->GetKey(SDL_SCANCODE_SPACE) == KEY_IDLE) {
+		Engine::GetInstance().input->GetAction(InputAction::JUMP).state == KEY_IDLE) {
 		spaceWasReleased = true;
 		hasDoubleJump = true;
 	}
 }
 
 void Player::DoubleJump() {
-	if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_SPACE) == KEY_DOWN &&
+	if (Engine::GetInstance().input->GetAction(InputAction::JUMP).state == KEY_DOWN &&
 		isJumping && spaceWasReleased && hasDoubleJump) {
 
 		b2Vec2 currentVel = Engine::GetInstance().physics->GetLinearVelocity(pbody);
@@ -283,13 +286,12 @@ void Player::Dash() {
 	if (dashCooldownTimer <= 0.0f && !isDashing) {
 
 		int desiredDashDir = 0;
-		if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_LSHIFT) == KEY_DOWN ||
-			Engine::GetInstance().input->GetKey(SDL_SCANCODE_RSHIFT) == KEY_DOWN) {
+		if (Engine::GetInstance().input->GetAction(InputAction::DASH).state == KEY_DOWN) {
 
-			if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_A) == KEY_REPEAT) {
+			if (Engine::GetInstance().input->GetAction(InputAction::LEFT).state == KEY_REPEAT) {
 				desiredDashDir = -1;
 			}
-			else if (Engine::GetInstance().input->GetKey(SDL_SCANCODE_D) == KEY_REPEAT) {
+			else if (Engine::GetInstance().input->GetAction(InputAction::RIGHT).state == KEY_REPEAT) {
 				desiredDashDir = 1;
 			}
 			else {
@@ -316,43 +318,90 @@ void Player::Dash() {
 }
 
 void Player::ApplyPhysics() {
-	if (godMode) {
-		b2Body_SetGravityScale(pbody->body, 0.0f);
-		b2Body_SetType(pbody->body, b2_kinematicBody);
+	// Only the velocity is written every frame, the body setup belongs to the state
+	if (state == PlayerState::GOD_MODE) {
 		Engine::GetInstance().physics->SetLinearVelocity(pbody, velocity);
 	}
 	else {
-		b2Body_SetGravityScale(pbody->body, 1.0f);
-		b2Body_SetType(pbody->body, b2_dynamicBody);
+		if (isDashing || isJumping) {
+			velocity.y = Engine::GetInstance().physics->GetYVelocity(pbody);
+		}
+		Engine::GetInstance().physics->SetLinearVelocity(pbody, velocity);
+	}
+}
 
-		if (isOnOneWayPlatform && currentOneWayPlatform != nullptr) {
-			int playerX, playerY;
-			pbody->GetPosition(playerX, playerY);
+void Player::UpdateState() {
+	PlayerState next;
+	if (isDead) {
+		next = PlayerState::DEAD;
+	}
+	else if (godMode) {
+		next = PlayerState::GOD_MODE;
+	}
+	else if (isDashing) {
+		next = PlayerState::DASHING;
+	}
+	else if (IsGrounded()) {
+		next = PlayerState::GROUNDED;
+	}
+	else {
+		next = PlayerState::AIRBORNE;
+	}
 
-			if (abs(playerY - oneWayPlatformY) > 2) {
-				pbody->SetPosition(playerX, oneWayPlatformY);
-			}
+	if (next != state) {
+		ChangeState(next);
+	}
+}
 
-			velocity.y = 0.0f;
-		}
-		if (isDashing) {
-			velocity.y = Engine::GetInstance().physics->GetYVelocity(pbody);
-			Engine::GetInstance().physics->SetLinearVelocity(pbody, velocity);
-		}
-		else if (isJumping) {
-			velocity.y = Engine::GetInstance().physics->GetYVelocity(pbody);
-			Engine::GetInstance().physics->SetLinearVelocity(pbody, velocity);
-		}
-		else {
-			Engine::GetInstance().physics->SetLinearVelocity(pbody, velocity);
-		}
+void Player::ChangeState(PlayerState newState) {
+	Physics* physics = Engine::GetInstance().physics.get();
+
+	// Leave the current state
+	if (state == PlayerState::GOD_MODE) {
+		physics->SetBodyType(pbody, bodyType::DYNAMIC);
+		physics->SetGravityScale(pbody, 1.0f);
+	}
+
+	// Enter the new one
+	switch (newState)
+	{
+	case PlayerState::GOD_MODE:
+		physics->SetBodyType(pbody, bodyType::KINEMATIC);
+		physics->SetGravityScale(pbody, 0.0f);
+		break;
+	case PlayerState::GROUNDED:
+		isJumping = false;
+		hasDoubleJump = false;
+		spaceWasReleased = false;
+		anims.SetCurrent("idle");
+		break;
+	default:
+		break;
 	}
+
+	state = newState;
+}
+
+bool Player::IsGrounded() const {
+	// Moving up (Y grows downwards)
+	if (velocity.y < 0.0f) return false;
+
+	int x, y;
+	pbody->GetPosition(x, y);
+
+	SDL_FRect feet = { (float)(x - texW / 2 + 2), (float)(y + texH / 2), (float)(texW - 4), groundProbeDepth };
+	Map* map = Engine::GetInstance().map.get();
+	if (map->OverlapsTiles(feet, TILE_MASK_SOLID)) return true;
+
+	// One-way tiles only count while the body is on top of them, not passing through
+	SDL_FRect body = { (float)(x - texW / 2), (float)(y - texH / 2), (float)texW, (float)texH - oneWayTolerance };
+	return map->OverlapsTiles(feet, TILE_MASK_ONEWAY) && !map->OverlapsTiles(body, TILE_MASK_ONEWAY);
 }
 
 void Player::Draw(float dt) {
 
 	anims.Update(dt);
-	const SDL_Rect& animFrame = anims.GetCurrentFrame();
+	SDL_Rect animFrame = sprite.Map(anims.GetCurrentFrame());
 
 	int x, y;
 	pbody->GetPosition(x, y);
@@ -365,7 +414,7 @@ void Player::Draw(float dt) {
 
 	}
 
-	Engine::GetInstance().render->DrawTexture(texture, x - texW / 2, y - texH / 2, &animFrame);
+	Engine::GetInstance().render->DrawTexture(sprite.texture, x - texW / 2, y - texH / 2, &animFrame);
 }
 
 void Player::UpdateCamera() {
@@ -401,67 +450,63 @@ void Player::UpdateCamera() {
 bool Player::CleanUp()
 {
 	LOG("Cleanup player");
-	Engine::GetInstance().textures->UnLoad(texture);
+	// The sprite belongs to the common atlas
 	return true;
 }
 
 void Player::OnCollision(PhysBody* physA, PhysBody* physB) {
-	// Ignore collisions when dead or in god mode (except items)
-	if (isDead || (godMode && physB->ctype != ColliderType::ITEM)) {
+	// Ignore collisions when dead or in god mode
+	if (isDead || godMode) {
 		return;
 	}
 
 	switch (physB->ctype)
 	{
-	case ColliderType::PLATFORM:
-		isJumping = false;
-		hasDoubleJump = false;
-		spaceWasReleased = false;
-		anims.SetCurrent("idle");
+	case ColliderType::ENEMY:
+		LOG("Player died: Hit damage object (spike/trap)!");
+		Die();
 		break;
-	case ColliderType::PLATFORM_ONEWAY:
-	{
-		if (lastYVelocity > 0.0f) {
-			int playerX, playerY;
-			pbody->GetPosition(playerX, playerY);
-
-			int platformX, platformY;
-			physB->GetPosition(platformX, platformY);
 
-			if (playerY < platformY - 8) {
+	case ColliderType::UNKNOWN:
+		LOG("Collision UNKNOWN");
+		break;
 
-				Engine::GetInstance().physics->SetLinearVelocity(pbody, velocity.x, 0.0f);
+	default:
+		break;
+	}
+}
 
-				isJumping = false;
-				hasDoubleJump = false;
-				spaceWasReleased = false;
-				anims.SetCurrent("idle");
+SDL_FRect Player::GetAABB() const {
+	SDL_FRect aabb = { position.getX() - texW / 2, position.getY() - texH / 2, (float)texW, (float)texH };
+	return aabb;
+}
 
-				isOnOneWayPlatform = true;
-				currentOneWayPlatform = physB;
-				oneWayPlatformY = playerY;  
+void Player::OnTriggerEnter(Trigger* trigger) {
+	if (isDead) return;
 
-				pbody->GetPosition(playerX, playerY);
-				oneWayPlatformY = playerY;
+	switch (trigger->type)
+	{
+	case TriggerType::COIN:
+		LOG("Trigger COIN");
+		Engine::GetInstance().audio->PlayFx(pickCoinFxId);
+		trigger->enabled = false;
+		if (trigger->listener != nullptr) trigger->listener->Destroy();
+		break;
 
-				LOG("Landed on ONE-WAY platform at Y: %d", playerY);
-			}
+	case TriggerType::CHECKPOINT:
+		if (godMode) break;
+		if (trigger->checkpoint != nullptr && !trigger->checkpoint->activated) {
+			ActivateCheckpoint(trigger->checkpoint);
 		}
 		break;
-	}
-	case ColliderType::ITEM:
-		LOG("Collision ITEM");
-		Engine::GetInstance().audio->PlayFx(pickCoinFxId);
-		physB->listener->Destroy();
-		break;
 
-	case ColliderType::ENEMY:
-		LOG("Player died: Hit damage object (spike/trap)!");
-		Die();
+	case TriggerType::SPAWN_ZONE:
+		LOG("Entered spawn zone: %s", trigger->name.c_str());
 		break;
 
-	case ColliderType::UNKNOWN:
-		LOG("Collision UNKNOWN");
+	case TriggerType::LEVEL_EXIT:
+		LOG("Level exit reached: %s", trigger->name.c_str());
+		Engine::GetInstance().scene->RequestNextLevel();
 		break;
 
 	default:
@@ -469,18 +514,6 @@ void Player::OnCollision(PhysBody* physA, PhysBody* physB) {
 	}
 }
 
-void Player::CheckCheckpoints() {
-	Checkpoint* nearbyCheckpoint = Engine::GetInstance().map->GetCheckpointAt(
-		position.getX(),
-		position.getY(),
-		checkpointRadius
-	);
-
-	if (nearbyCheckpoint != nullptr && !nearbyCheckpoint->activated) {
-		ActivateCheckpoint(nearbyCheckpoint);
-	}
-}
-
 void Player::ActivateCheckpoint(Checkpoint* checkpoint) {
 	if (checkpoint == nullptr) return;
 
@@ -495,16 +528,7 @@ void Player::ActivateCheckpoint(Checkpoint* checkpoint) {
 	spawnPosition.setY(checkpoint->y);
 
 	LOG("=== CHECKPOINT ACTIVADO ===");
-	LOG("Checkpoint: %s", checkpoint->name.c_str());
+	LOG("Checkpoint: %s", checkpoint->name);
 	LOG("Nueva posicion de respawn: (%.2f, %.2f)", spawnPosition.getX(), spawnPosition.getY());
 
 }
-
-void Player::OnCollisionEnd(PhysBody* physA, PhysBody* physB)
-{
-	if (physB->ctype == ColliderType::PLATFORM_ONEWAY && physB == currentOneWayPlatform) {
-		isOnOneWayPlatform = false;
-		currentOneWayPlatform = nullptr;
-		LOG("Left ONE-WAY platform");
-	}
-}
\ No newline at end of file
@@ -2,12 +2,22 @@
 
 #include "Entity.h"
 #include "Animation.h"
+#include "TextureAtlas.h"
 #include <box2d/box2d.h>
 #include <SDL3/SDL.h>
 
-struct SDL_Texture;
 struct Checkpoint;
 
+// Controller states. Body type, gravity and collision filters only change on transitions
+enum class PlayerState
+{
+	GROUNDED,
+	AIRBORNE,
+	DASHING,
+	GOD_MODE,
+	DEAD
+};
+
 class Player : public Entity
 {
 public:
@@ -26,7 +36,9 @@ public:
 
 	// L08 TODO 6: Define OnCollision function for the player. 
 	void OnCollision(PhysBody* physA, PhysBody* physB);
-	void OnCollisionEnd(PhysBody* physA, PhysBody* physB);
+
+	// Coins, checkpoints and level exits
+	void OnTriggerEnter(Trigger* trigger);
 
 	// Load player parameters from XML
 	bool LoadParameters(pugi::xml_node parameters);
@@ -42,6 +54,11 @@ private:
 	void Teleport();
 	void ApplyPhysics();
 	void Draw(float dt);
+
+	// State machine
+	void UpdateState();
+	void ChangeState(PlayerState newState);
+	bool IsGrounded() const;
 	void UpdateCamera();
 
 	// Sistema de muerte y respawn
@@ -58,7 +75,7 @@ public:
 	int dashDuration = 200;      // milliseconds
 	int dashCooldown = 500;      // milliseconds
 
-	SDL_Texture* texture = nullptr;
+	TextureRegion sprite;   // spritesheet in the common atlas, animation frames are mapped into it
 	int texW = 32;
 	int texH = 32;
 
@@ -88,6 +105,9 @@ public:
 	// God mode
 	bool godMode = false;
 
+	// Current controller state
+	PlayerState state = PlayerState::AIRBORNE;
+
 	// Death system
 	bool isDead = false;
 	float respawnTimer = 0.0f;
@@ -96,19 +116,21 @@ public:
 
 	void ActivateCheckpoint(Checkpoint* checkpoint);
 
+	// The checkpoints belong to the level, forget the current one when it is unloaded
+	void ResetCheckpoint() { currentCheckpoint = nullptr; }
+
 private:
 	b2Vec2 velocity = { 0.0f, 0.0f };
 	AnimationSet anims;
 	
 	Checkpoint* currentCheckpoint = nullptr;
-	float checkpointRadius = 32.0f;
-	void CheckCheckpoints();
-	
-	bool isOnOneWayPlatform = false;
-	PhysBody* currentOneWayPlatform = nullptr;
-	int oneWayPlatformY = 0;
-	float lastYVelocity = 0.0f;
+
+	// Player AABB in pixels, used to query the trigger system
+	SDL_FRect GetAABB() const;
 	
+	// Grounding probe, one-way platforms are resolved by Physics::PreSolveCb
+	float oneWayTolerance = 4.0f; // pixels the body may sink into a one-way tile
+	float groundProbeDepth = 2.0f;
 
 	// Configuration paths (loaded from XML)
 	std::string texturePath;
@@ -7,6 +7,24 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+void RenderCounters::Add(const RenderCounters& other)
+{
+	drawCalls += other.drawCalls;
+	sprites += other.sprites;
+	textureSwitches += other.textureSwitches;
+	stateChanges += other.stateChanges;
+	primitives += other.primitives;
+	culled += other.culled;
+}
+
+RenderCounters RenderStats::Total() const
+{
+	RenderCounters total;
+	for (const RenderCounters& counters : tags)
+		total.Add(counters);
+	return total;
+}
+
 Render::Render() : Module()
 {
 	name = "render";
@@ -60,6 +78,14 @@ bool Render::Awake()
 		camera.h = Engine::GetInstance().window->height * scale;
 		camera.x = 0;
 		camera.y = 0;
+
+		pugi::xml_node resolution = configParameters.child("internalResolution");
+		std::string mode = resolution.attribute("mode").as_string("native");
+		if (mode == "fixed") resolutionMode = ResolutionMode::FIXED;
+		else if (mode == "dynamic") resolutionMode = ResolutionMode::DYNAMIC;
+		internalWidth = SDL_max(1, resolution.attribute("width").as_int(640));
+		internalHeight = SDL_max(1, resolution.attribute("height").as_int(360));
+		UpdateTarget();
 	}
 
 	return ret;
@@ -80,7 +106,26 @@ bool Render::Start()
 // Called each loop iteration
 bool Render::PreUpdate()
 {
+	if (resolutionMode != ResolutionMode::NATIVE)
+	{
+		// The window may have been resized
+		int w = 0, h = 0;
+		SDL_GetRenderOutputSize(renderer, &w, &h);
+		if (w != outputWidth || h != outputHeight)
+			UpdateTarget();
+	}
+
+	// Draw coordinates stay in window pixels, the render scale maps them to the target
+	if (target != nullptr)
+	{
+		SDL_SetRenderTarget(renderer, target);
+		SDL_SetRenderScale(renderer, (float)targetWidth / camera.w, (float)targetHeight / camera.h);
+	}
+
 	SDL_RenderClear(renderer);
+
+	// Anything may have changed the draw state since the last frame (clear color, overlays)
+	InvalidateDrawState();
 	return true;
 }
 
@@ -91,11 +136,22 @@ bool Render::Update(float dt)
 
 bool Render::PostUpdate()
 {
+	ResolveTarget();
+
 	// Draw debug help BEFORE presenting
-	Engine::GetInstance().DrawDebugHelp();
+	{
+		RenderTagScope uiTag(*this, RenderTag::UI);
+		Engine::GetInstance().DrawDebugHelp();
+	}
+
+	// The HUD shows these, it draws with SDL directly and is not counted
+	lastStats = stats;
+	stats = RenderStats();
+	Engine::GetInstance().DrawPerfHud();
 
 	SDL_SetRenderDrawColor(renderer, background.r, background.g, background.g, background.a);
 	SDL_RenderPresent(renderer);
+	lastPresentTime = SDL_GetTicksNS();
 	return true;
 }
 
@@ -103,10 +159,176 @@ bool Render::PostUpdate()
 bool Render::CleanUp()
 {
 	LOG("Destroying SDL render");
+	if (target != nullptr)
+	{
+		SDL_DestroyTexture(target);
+		target = nullptr;
+	}
 	SDL_DestroyRenderer(renderer);
 	return true;
 }
 
+void Render::UpdateTarget()
+{
+	SDL_GetRenderOutputSize(renderer, &outputWidth, &outputHeight);
+
+	int w = outputWidth;
+	int h = outputHeight;
+	int factor = 1;
+	if (resolutionMode == ResolutionMode::FIXED)
+	{
+		w = internalWidth;
+		h = internalHeight;
+		factor = SDL_max(1, SDL_min(outputWidth / w, outputHeight / h));
+	}
+	else if (resolutionMode == ResolutionMode::DYNAMIC)
+	{
+		// Never under the configured size
+		maxDivisor = SDL_max(1, SDL_min(outputWidth / internalWidth, outputHeight / internalHeight));
+		divisor = SDL_min(divisor, maxDivisor);
+		w = outputWidth / divisor;
+		h = outputHeight / divisor;
+		factor = divisor;
+	}
+
+	if (target != nullptr && w == targetWidth && h == targetHeight)
+		return;
+
+	if (target != nullptr)
+	{
+		SDL_DestroyTexture(target);
+		target = nullptr;
+	}
+
+	targetWidth = w;
+	targetHeight = h;
+
+	// Same size as the window: no need for the copy
+	if (resolutionMode == ResolutionMode::NATIVE || (w == outputWidth && h == outputHeight))
+		return;
+
+	target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h);
+	if (target == NULL)
+	{
+		LOG("Could not create the %dx%d render target, drawing to the window: %s", w, h, SDL_GetError());
+		targetWidth = outputWidth;
+		targetHeight = outputHeight;
+		return;
+	}
+	SDL_SetTextureScaleMode(target, SDL_SCALEMODE_NEAREST);
+	SDL_SetTextureBlendMode(target, SDL_BLENDMODE_NONE);
+
+	// Centered, the rest of the window stays black
+	presentRect.w = (float)(w * factor);
+	presentRect.h = (float)(h * factor);
+	presentRect.x = (float)((outputWidth - w * factor) / 2);
+	presentRect.y = (float)((outputHeight - h * factor) / 2);
+
+	LOG("Render: world at %dx%d, upscaled x%d to %dx%d", w, h, factor, outputWidth, outputHeight);
+}
+
+void Render::ResolveTarget()
+{
+	if (target == nullptr)
+		return;
+
+	SDL_SetRenderTarget(renderer, NULL);
+	SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+	SDL_RenderClear(renderer);
+	SDL_RenderTexture(renderer, target, NULL, &presentRect);
+	++Counters().drawCalls;
+
+	// The clear color and the texture changed behind the cache
+	InvalidateDrawState();
+}
+
+void Render::AdaptResolution(float frameMs, float budgetMs)
+{
+	if (resolutionMode != ResolutionMode::DYNAMIC || budgetMs <= 0.0f)
+		return;
+
+	adaptSumMs += frameMs;
+	if (++adaptFrames < RENDER_ADAPT_FRAMES)
+		return;
+
+	float average = adaptSumMs / adaptFrames;
+	adaptSumMs = 0.0f;
+	adaptFrames = 0;
+
+	int next = divisor;
+	if (average > budgetMs * RENDER_ADAPT_DROP && divisor < maxDivisor)
+	{
+		++next;
+	}
+	else if (divisor > 1)
+	{
+		// Pessimistic guess: all the frame is fill, which grows with the pixel count.
+		// Keeps it from going up and straight back down
+		float ratio = (float)divisor / (divisor - 1);
+		if (average * ratio * ratio < budgetMs * RENDER_ADAPT_RAISE)
+			--next;
+	}
+
+	if (next != divisor)
+	{
+		LOG("Render: %.2f ms average for a %.2f ms budget, resolution divisor %d -> %d", average, budgetMs, divisor, next);
+		divisor = next;
+		UpdateTarget();
+	}
+}
+
+void Render::GetInternalResolution(int& width, int& height) const
+{
+	width = targetWidth;
+	height = targetHeight;
+}
+
+RenderTag Render::SetTag(RenderTag newTag)
+{
+	RenderTag previous = tag;
+	tag = newTag;
+	return previous;
+}
+
+const char* Render::TagName(RenderTag tag)
+{
+	static const char* names[RENDER_TAG_COUNT] = { "map", "entities", "debug", "ui", "other" };
+	int index = (int)tag;
+	return index >= 0 && index < RENDER_TAG_COUNT ? names[index] : "?";
+}
+
+void Render::InvalidateDrawState()
+{
+	stateValid = false;
+	lastTexture = nullptr;
+}
+
+void Render::SetDrawState(Uint8 r, Uint8 g, Uint8 b, Uint8 a) const
+{
+	if (!stateValid || blendMode != SDL_BLENDMODE_BLEND)
+	{
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		blendMode = SDL_BLENDMODE_BLEND;
+		++Counters().stateChanges;
+	}
+
+	if (!stateValid || drawColor.r != r || drawColor.g != g || drawColor.b != b || drawColor.a != a)
+	{
+		SDL_SetRenderDrawColor(renderer, r, g, b, a);
+		drawColor = { r, g, b, a };
+		++Counters().stateChanges;
+	}
+
+	stateValid = true;
+}
+
+bool Render::IsOffScreen(const SDL_FRect& rect, float margin) const
+{
+	return rect.x + rect.w + margin < 0.0f || rect.y + rect.h + margin < 0.0f ||
+		rect.x - margin > (float)camera.w || rect.y - margin > (float)camera.h;
+}
+
 void Render::SetBackgroundColor(SDL_Color color)
 {
 	background = color;
@@ -161,6 +383,13 @@ bool Render::DrawTexture(SDL_Texture* texture, int x, int y, const SDL_Rect* sec
 		src = &srcRect;
 	}
 
+	// Rotated sprites can reach outside their rect
+	if (IsOffScreen(rect, angle != 0.0 ? SDL_max(rect.w, rect.h) : 0.0f))
+	{
+		++Counters().culled;
+		return true;
+	}
+
 	SDL_FPoint* p = NULL;
 	SDL_FPoint pivot;
 	if (pivotX != INT_MAX && pivotY != INT_MAX)
@@ -170,6 +399,15 @@ bool Render::DrawTexture(SDL_Texture* texture, int x, int y, const SDL_Rect* sec
 		p = &pivot;
 	}
 
+	RenderCounters& counters = Counters();
+	if (texture != lastTexture)
+	{
+		++counters.textureSwitches;
+		lastTexture = texture;
+	}
+	++counters.sprites;
+	++counters.drawCalls;
+
 	// SDL3: returns bool; map to int-style check
 	int rc = SDL_RenderTextureRotated(renderer, texture, src, &rect, angle, p, SDL_FLIP_NONE) ? 0 : -1;
 	if (rc != 0)
@@ -186,9 +424,6 @@ bool Render::DrawRectangle(const SDL_Rect& rect, Uint8 r, Uint8 g, Uint8 b, Uint
 	bool ret = true;
 	int scale = Engine::GetInstance().window->GetScale();
 
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-	SDL_SetRenderDrawColor(renderer, r, g, b, a);
-
 	SDL_FRect rec;
 	if (use_camera)
 	{
@@ -205,6 +440,15 @@ bool Render::DrawRectangle(const SDL_Rect& rect, Uint8 r, Uint8 g, Uint8 b, Uint
 		rec.h = (float)(rect.h * scale);
 	}
 
+	if (IsOffScreen(rec, 0.0f))
+	{
+		++Counters().culled;
+		return true;
+	}
+
+	SetDrawState(r, g, b, a);
+	++Counters().primitives;
+	++Counters().drawCalls;
 	int result = (filled ? SDL_RenderFillRect(renderer, &rec) : SDL_RenderRect(renderer, &rec)) ? 0 : -1;
 
 	if (result != 0)
@@ -221,9 +465,6 @@ bool Render::DrawLine(int x1, int y1, int x2, int y2, Uint8 r, Uint8 g, Uint8 b,
 	bool ret = true;
 	int scale = Engine::GetInstance().window->GetScale();
 
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-	SDL_SetRenderDrawColor(renderer, r, g, b, a);
-
 	float X1, Y1, X2, Y2;
 
 	if (use_camera)
@@ -241,6 +482,16 @@ bool Render::DrawLine(int x1, int y1, int x2, int y2, Uint8 r, Uint8 g, Uint8 b,
 		Y2 = (float)(y2 * scale);
 	}
 
+	SDL_FRect bounds = { SDL_min(X1, X2), SDL_min(Y1, Y2), SDL_fabsf(X2 - X1), SDL_fabsf(Y2 - Y1) };
+	if (IsOffScreen(bounds, 1.0f))
+	{
+		++Counters().culled;
+		return true;
+	}
+
+	SetDrawState(r, g, b, a);
+	++Counters().primitives;
+	++Counters().drawCalls;
 	int result = SDL_RenderLine(renderer, X1, Y1, X2, Y2) ? 0 : -1;
 
 	if (result != 0)
@@ -257,9 +508,6 @@ bool Render::DrawCircle(int x, int y, int radius, Uint8 r, Uint8 g, Uint8 b, Uin
 	bool ret = true;
 	int scale = Engine::GetInstance().window->GetScale();
 
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-	SDL_SetRenderDrawColor(renderer, r, g, b, a);
-
 	int result = -1;
 	SDL_FPoint points[360];
 
@@ -268,12 +516,22 @@ bool Render::DrawCircle(int x, int y, int radius, Uint8 r, Uint8 g, Uint8 b, Uin
 	float cx = (float)((use_camera ? camera.x : 0) + x * scale);
 	float cy = (float)((use_camera ? camera.y : 0) + y * scale);
 
+	SDL_FRect bounds = { cx - radius, cy - radius, 2.0f * radius, 2.0f * radius };
+	if (IsOffScreen(bounds, 0.0f))
+	{
+		++Counters().culled;
+		return true;
+	}
+
 	for (int i = 0; i < 360; ++i)
 	{
 		points[i].x = cx + (float)(radius * cos(i * factor));
 		points[i].y = cy + (float)(radius * sin(i * factor));
 	}
 
+	SetDrawState(r, g, b, a);
+	++Counters().primitives;
+	++Counters().drawCalls;
 	result = SDL_RenderPoints(renderer, points, 360) ? 0 : -1;
 
 	if (result != 0)
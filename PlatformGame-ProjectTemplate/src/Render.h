@@ -4,6 +4,50 @@
 #include "Vector2D.h"
 #include "SDL3/SDL.h"
 
+// Who submitted the draws, for the per-frame counters
+enum class RenderTag
+{
+	MAP,
+	ENTITIES,
+	DEBUG,
+	UI,
+	OTHER,
+	COUNT
+};
+
+#define RENDER_TAG_COUNT ((int)RenderTag::COUNT)
+
+#define RENDER_ADAPT_FRAMES 30     // frames averaged before the dynamic resolution is reconsidered
+#define RENDER_ADAPT_DROP 1.1f     // lower the resolution over budget * this (vsync frames sit right at the budget)
+#define RENDER_ADAPT_RAISE 0.8f    // raise it when the estimate at the next size is under budget * this
+
+// Where the world is drawn
+enum class ResolutionMode
+{
+	NATIVE,    // straight to the window
+	FIXED,     // offscreen target of a fixed size, upscaled by an integer factor
+	DYNAMIC    // offscreen target of window size / divisor, the divisor follows the frame time
+};
+
+struct RenderCounters
+{
+	int drawCalls = 0;        // SDL_Render* submissions
+	int sprites = 0;          // DrawTexture calls that were drawn
+	int textureSwitches = 0;  // sprite using another texture than the previous one
+	int stateChanges = 0;     // blend mode / draw color actually changed
+	int primitives = 0;       // rects, lines and circles
+	int culled = 0;           // draws skipped because they were off screen
+
+	void Add(const RenderCounters& other);
+};
+
+struct RenderStats
+{
+	RenderCounters tags[RENDER_TAG_COUNT];
+
+	RenderCounters Total() const;
+};
+
 class Render : public Module
 {
 public:
@@ -39,6 +83,21 @@ public:
 	// Set background color
 	void SetBackgroundColor(SDL_Color color);
 
+	// Counters of the last presented frame, per tag (the performance HUD is not counted)
+	const RenderStats& GetStats() const { return lastStats; }
+	int GetDrawCalls() const { return lastStats.Total().drawCalls; }
+
+	// Tag of the next draws, returns the previous one
+	RenderTag SetTag(RenderTag tag);
+	static const char* TagName(RenderTag tag);
+
+	// SDL_GetTicksNS() right after the last SDL_RenderPresent returned
+	Uint64 GetLastPresentTime() const { return lastPresentTime; }
+
+	// Dynamic resolution: frame time without the frame cap delay, and the budget (ms)
+	void AdaptResolution(float frameMs, float budgetMs);
+	void GetInternalResolution(int& width, int& height) const;
+
 public:
 
 	SDL_Renderer* renderer;
@@ -48,4 +107,60 @@ public:
 
 private:
 	bool vsync = false;
+	Uint64 lastPresentTime = 0;
+
+	// (Re)creates the offscreen target for the current mode and output size
+	void UpdateTarget();
+	// Upscales the world to the window, UI and HUD are drawn after it at native resolution
+	void ResolveTarget();
+
+	ResolutionMode resolutionMode = ResolutionMode::NATIVE;
+	SDL_Texture* target = nullptr;   // null while the world is drawn to the window
+	int internalWidth = 640;         // FIXED size, and the smallest DYNAMIC size
+	int internalHeight = 360;
+	int divisor = 1;                 // DYNAMIC: output size / divisor
+	int maxDivisor = 1;
+	int outputWidth = 0;
+	int outputHeight = 0;
+	int targetWidth = 0;
+	int targetHeight = 0;
+	SDL_FRect presentRect = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float adaptSumMs = 0.0f;
+	int adaptFrames = 0;
+
+	// Skips the blend mode / color calls that change nothing, counts the others
+	void SetDrawState(Uint8 r, Uint8 g, Uint8 b, Uint8 a) const;
+	void InvalidateDrawState();
+
+	// Off the render output (pixels), margin for rotated sprites
+	bool IsOffScreen(const SDL_FRect& rect, float margin) const;
+
+	RenderCounters& Counters() const { return stats.tags[(int)tag]; }
+
+	mutable RenderStats stats;   // this frame
+	RenderStats lastStats;
+	RenderTag tag = RenderTag::OTHER;
+
+	// Draw state last set through this class, invalidated every frame
+	mutable bool stateValid = false;
+	mutable SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+	mutable SDL_Color drawColor = { 0, 0, 0, 0 };
+	mutable SDL_Texture* lastTexture = nullptr;
+};
+
+// Sets the render tag for the lifetime of the scope
+class RenderTagScope
+{
+public:
+
+	RenderTagScope(Render& render, RenderTag tag) : render(render), previous(render.SetTag(tag)) {}
+	~RenderTagScope() { render.SetTag(previous); }
+
+	RenderTagScope(const RenderTagScope&) = delete;
+	RenderTagScope& operator=(const RenderTagScope&) = delete;
+
+private:
+
+	Render& render;
+	RenderTag previous;
 };
@@ -47,6 +47,13 @@ bool Scene::Awake()
 		}
 	}
 
+	for (pugi::xml_node levelNode = configParameters.child("levels").child("level"); levelNode; levelNode = levelNode.next_sibling("level")) {
+		levelFiles.push_back(levelNode.attribute("file").as_string());
+	}
+	if (levelFiles.empty()) {
+		levelFiles.push_back(SCENE_DEFAULT_LEVEL);
+	}
+
 	//L08: TODO 4: Create a new item using the entity manager and set the position to (200, 672) to test
 	std::shared_ptr<Item> item = std::dynamic_pointer_cast<Item>(Engine::GetInstance().entityManager->CreateEntity(EntityType::ITEM));
 	item->position = Vector2D(200, 672);
@@ -65,22 +72,9 @@ bool Scene::Start()
 	Engine::GetInstance().audio->PlayMusic("Assets/Audio/Music/background_music.wav");
 
 
-	LoadLevel(1);
 	//L06 TODO 3: Call the function to load the map. 
-	Engine::GetInstance().map->Load("Assets/Maps/", "MapTemplate.tmx");
-	
-	Vector2D spawnPos = Engine::GetInstance().map->GetPlayerSpawnPosition();
-
-	if (player) {
-		player->position = spawnPos;
-		player->spawnPosition = spawnPos;
-
-		if (player->pbody) {
-			player->pbody->SetPosition((int)spawnPos.getX(), (int)spawnPos.getY());
-		}
-
-		LOG("Player position set to spawn: (%.2f, %.2f)", spawnPos.getX(), spawnPos.getY());
-	}
+	// The only map loading path: startLevel picks the map
+	LoadLevel(startLevel);
 
 	return true;
 }
@@ -117,6 +111,12 @@ bool Scene::PostUpdate()
 	if(Engine::GetInstance().input->GetKey(SDL_SCANCODE_ESCAPE) == KEY_DOWN)
 		ret = false;
 
+	if (pendingLevel != 0) {
+		int level = pendingLevel;
+		pendingLevel = 0;
+		LoadLevel(level);
+	}
+
 	return ret;
 }
 
@@ -127,17 +127,44 @@ bool Scene::CleanUp()
 	return true;
 }
 
-void Scene::LoadLevel(int levelNumber) {
+bool Scene::LoadLevel(int levelNumber) {
+	MemorySnapshot before = Engine::GetInstance().GetMemorySnapshot();
+
 	// Descargar nivel anterior
 	UnloadLevel();
 
-	currentLevel = levelNumber;
+	bool ret = LoadLevelMap(levelNumber);
+	if (ret) {
+		currentLevel = levelNumber;
+		LOG("Level %d loaded", levelNumber);
+	}
+	else {
+		LOG("Could not load level %d, staying on level %d", levelNumber, currentLevel);
+		UnloadLevel();
+		LoadLevelMap(currentLevel);
+	}
+
+	// What the level change cost: the unloaded level should give back what the new one takes
+	MemorySnapshot after = Engine::GetInstance().GetMemorySnapshot();
+	std::string label = "LoadLevel(" + std::to_string(levelNumber) + ")";
+	MemoryTracker::LogDiff(before, after, label.c_str());
 
-	std::string levelFile = "Level" + std::to_string(levelNumber) + ".tmx";
-	Engine::GetInstance().map->Load("Assets/Maps/", levelFile);
+	return ret;
+}
+
+bool Scene::LoadLevelMap(int levelNumber) {
+	if (levelNumber < 1 || levelNumber > (int)levelFiles.size()) {
+		LOG("Level %d does not exist, there are %d levels", levelNumber, (int)levelFiles.size());
+		return false;
+	}
+
+	if (!Engine::GetInstance().map->Load(SCENE_LEVEL_DIR, levelFiles[levelNumber - 1])) {
+		return false;
+	}
 
 	Vector2D spawnPos = Engine::GetInstance().map->GetPlayerSpawnPosition();
 	if (player) {
+		player->ResetCheckpoint();
 		player->position = spawnPos;
 		player->spawnPosition = spawnPos;
 		if (player->pbody) {
@@ -145,10 +172,19 @@ void Scene::LoadLevel(int levelNumber) {
 		}
 	}
 
-	LOG("Level %d loaded", levelNumber);
+	// Coins and the like created by Map::Load
+	Engine::GetInstance().entityManager->StartLevelEntities();
+	return true;
 }
 
 void Scene::UnloadLevel() {
 	Engine::GetInstance().map->CleanUp();
 	LOG("Level unloaded");
+}
+
+void Scene::RequestNextLevel() {
+	// After the last level, back to the first one
+	if (pendingLevel == 0) {
+		pendingLevel = currentLevel % (int)levelFiles.size() + 1;
+	}
 }
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #include "Module.h"
 #include "Player.h"
+#include <string>
+#include <vector>
+
+#define SCENE_LEVEL_DIR "Assets/Maps/"
+#define SCENE_DEFAULT_LEVEL "MapTemplate.tmx"   // when config.xml has no <levels>
 
 struct SDL_Texture;
 
@@ -35,14 +40,31 @@ public:
 	// Get player pointer
 	std::shared_ptr<Player> GetPlayer() { return player; }
 
-	void LoadLevel(int levelNumber);
+	// Loads level n (1-based, <levels> in config.xml). If it can't be loaded the current level is
+	// loaded again, so the world is never left empty. Returns false in that case
+	bool LoadLevel(int levelNumber);
 
 	void UnloadLevel();
+
+	// Deferred level change (e.g. from a trigger callback), applied in PostUpdate
+	void RequestNextLevel();
+
+	// Level loaded by Start (set by an input replay)
+	int startLevel = 1;
+
+	// Level on screen, LoadLevel may have fallen back to it
+	int GetCurrentLevel() const { return currentLevel; }
 private:
 
 
 	//L03: TODO 3b: Declare a Player attribute
 	std::shared_ptr<Player> player;
+
+	// Map of the level, spawns the player and starts the level entities
+	bool LoadLevelMap(int levelNumber);
+
+	std::vector<std::string> levelFiles;
 	int currentLevel = 1;
+	int pendingLevel = 0;
 
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Capacity must be a power of two, one slot is kept empty to tell full from empty.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+
+	// Producer side, returns false when the queue is full
+	bool Push(const T& item)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		const size_t next = (tail + 1) & (Capacity - 1);
+		if (next == head_.load(std::memory_order_acquire)) return false;
+
+		items_[tail] = item;
+		tail_.store(next, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side, returns false when the queue is empty
+	bool Pop(T& item)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) return false;
+
+		item = items_[head];
+		head_.store((head + 1) & (Capacity - 1), std::memory_order_release);
+		return true;
+	}
+
+	bool Empty() const
+	{
+		return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+	}
+
+private:
+
+	T items_[Capacity];
+
+	// Written by the consumer / producer only, kept on separate cache lines
+	alignas(64) std::atomic<size_t> head_{ 0 };
+	alignas(64) std::atomic<size_t> tail_{ 0 };
+};
@@ -0,0 +1,54 @@
+#include "Stats.h"
+#include <algorithm>
+#include <cmath>
+
+void RollingStats::Add(float value)
+{
+	samples[next] = value;
+	next = (next + 1) % ROLLING_STATS_WINDOW;
+	if (count < ROLLING_STATS_WINDOW)
+		++count;
+}
+
+void RollingStats::Clear()
+{
+	next = 0;
+	count = 0;
+}
+
+float PercentileOf(float* values, int count, float p)
+{
+	if (count <= 0)
+		return 0.0f;
+
+	int rank = (int)std::ceil(p / 100.0f * count) - 1;
+	rank = std::max(0, std::min(count - 1, rank));
+	std::nth_element(values, values + rank, values + count);
+	return values[rank];
+}
+
+float RollingStats::Percentile(float p) const
+{
+	float sorted[ROLLING_STATS_WINDOW];
+	std::copy(samples, samples + count, sorted);
+	return PercentileOf(sorted, count, p);
+}
+
+float RollingStats::Mean() const
+{
+	if (count == 0)
+		return 0.0f;
+
+	float sum = 0.0f;
+	for (int i = 0; i < count; ++i)
+		sum += samples[i];
+	return sum / count;
+}
+
+float RollingStats::Max() const
+{
+	float max = 0.0f;
+	for (int i = 0; i < count; ++i)
+		max = std::max(max, samples[i]);
+	return max;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#define ROLLING_STATS_WINDOW 256
+
+// Nearest-rank percentile (p from 0 to 100) of 'count' values, reorders them
+float PercentileOf(float* values, int count, float p);
+
+// Last ROLLING_STATS_WINDOW samples of a measure, with percentiles over them.
+// Adding is O(1) and never allocates, the percentiles sort a copy on demand.
+class RollingStats
+{
+public:
+
+	void Add(float value);
+	void Clear();
+
+	int Count() const { return count; }
+
+	// Nearest-rank percentile, p from 0 to 100 (0 if there are no samples)
+	float Percentile(float p) const;
+	float Mean() const;
+	float Max() const;
+
+	// Sample by age, 0 is the newest (age < Count())
+	float Get(int age) const { return samples[(next - 1 - age + 2 * ROLLING_STATS_WINDOW) % ROLLING_STATS_WINDOW]; }
+
+private:
+
+	float samples[ROLLING_STATS_WINDOW];
+	int next = 0;
+	int count = 0;
+};
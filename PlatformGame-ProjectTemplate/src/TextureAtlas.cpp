@@ -0,0 +1,102 @@
+#include "TextureAtlas.h"
+#include <climits>
+
+void SkylinePacker::Init(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	usedArea = 0;
+	skyline.clear();
+	skyline.push_back({ 0, 0, width });
+}
+
+bool SkylinePacker::Insert(int w, int h, SDL_Rect& out)
+{
+	size_t bestIndex = SIZE_MAX;
+	int bestTop = INT_MAX;
+	int bestWidth = INT_MAX;
+
+	for (size_t i = 0; i < skyline.size(); ++i)
+	{
+		int y = Fit(i, w, h);
+		if (y < 0)
+			continue;
+
+		// Lowest top edge first, then the narrowest segment so the skyline stays flat
+		if (y + h < bestTop || (y + h == bestTop && skyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = y + h;
+			bestWidth = skyline[i].width;
+			out = { skyline[i].x, y, w, h };
+		}
+	}
+
+	if (bestIndex == SIZE_MAX)
+		return false;
+
+	AddSegment(bestIndex, out);
+	usedArea += (int64_t)w * h;
+	return true;
+}
+
+float SkylinePacker::GetOccupancy() const
+{
+	if (width == 0 || height == 0)
+		return 0.0f;
+	return (float)usedArea / ((float)width * height);
+}
+
+int SkylinePacker::Fit(size_t index, int w, int h) const
+{
+	if (skyline[index].x + w > width)
+		return -1;
+
+	// The rect rests on the highest segment it spans
+	int y = 0;
+	int left = w;
+	for (size_t i = index; left > 0; ++i)
+	{
+		y = SDL_max(y, skyline[i].y);
+		if (y + h > height)
+			return -1;
+		left -= skyline[i].width;
+	}
+	return y;
+}
+
+void SkylinePacker::AddSegment(size_t index, const SDL_Rect& rect)
+{
+	skyline.insert(skyline.begin() + index, { rect.x, rect.y + rect.h, rect.w });
+
+	// Cut the segments now covered by the new one
+	size_t i = index + 1;
+	while (i < skyline.size())
+	{
+		int coveredEnd = skyline[i - 1].x + skyline[i - 1].width;
+		if (skyline[i].x >= coveredEnd)
+			break;
+
+		int overlap = coveredEnd - skyline[i].x;
+		skyline[i].x += overlap;
+		skyline[i].width -= overlap;
+		if (skyline[i].width > 0)
+			break;
+		skyline.erase(skyline.begin() + i);
+	}
+
+	// Merge neighbours at the same height
+	i = 0;
+	while (i + 1 < skyline.size())
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
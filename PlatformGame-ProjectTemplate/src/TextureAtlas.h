@@ -0,0 +1,59 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+
+// Atlas pages of the LEVEL group are released together when the map is unloaded,
+// COMMON pages (player, coins) live until Textures::CleanUp
+enum class AtlasGroup
+{
+	COMMON,
+	LEVEL
+};
+
+// Where an image ended up: its atlas page and its rect inside the page
+struct TextureRegion
+{
+	SDL_Texture* texture = nullptr;
+	SDL_Rect rect = { 0, 0, 0, 0 };
+
+	// Moves a source rect given in the original image into the page
+	SDL_Rect Map(const SDL_Rect& section) const
+	{
+		return { rect.x + section.x, rect.y + section.y, section.w, section.h };
+	}
+};
+
+// Skyline bottom-left packer: the top edge of the packed area is kept as a list of
+// horizontal segments and each rect goes where its top edge ends lowest
+class SkylinePacker
+{
+public:
+
+	void Init(int width, int height);
+
+	// Finds a place for a w x h rect, false when the page has no room for it
+	bool Insert(int w, int h, SDL_Rect& out);
+
+	// Packed area / page area
+	float GetOccupancy() const;
+
+private:
+
+	struct Segment
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	// y where a w x h rect starting on segment 'index' would sit, -1 if it doesn't fit
+	int Fit(size_t index, int w, int h) const;
+	void AddSegment(size_t index, const SDL_Rect& rect);
+
+	int width = 0;
+	int height = 0;
+	int64_t usedArea = 0;
+	std::vector<Segment> skyline;
+};
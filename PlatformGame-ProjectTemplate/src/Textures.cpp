@@ -2,10 +2,18 @@
 #include "Render.h"
 #include "Textures.h"
 #include "Log.h"
+#include "MemoryTracker.h"
+
+// Pixel bytes of a texture, for the memory accounting
+static int64_t TextureBytes(const SDL_Texture* texture)
+{
+	return (int64_t)texture->w * texture->h * SDL_BYTESPERPIXEL(texture->format);
+}
 
 Textures::Textures() : Module()
 {
 	name = "textures";
+	memTag = MemTag::TEXTURES;
 }
 
 // Destructor
@@ -19,6 +27,11 @@ bool Textures::Awake()
 	LOG("Init Image library");
 	bool ret = true;
 
+	pugi::xml_node atlas = configParameters.child("atlas");
+	atlasLevelSize = atlas.attribute("levelSize").as_int(ATLAS_LEVEL_SIZE);
+	atlasCommonSize = atlas.attribute("commonSize").as_int(ATLAS_COMMON_SIZE);
+	atlasPadding = atlas.attribute("padding").as_int(ATLAS_PADDING);
+
 	return ret;
 }
 
@@ -35,9 +48,13 @@ bool Textures::CleanUp()
 {
 	LOG("Freeing textures and Image library");
 	for (const auto& texture : textures) {
+		MemoryTracker::Add(MemTag::TEXTURES, -TextureBytes(texture), -1);
 		SDL_DestroyTexture(texture);
 	}
 	textures.clear();
+	// The page textures were in the list above
+	atlasPages.clear();
+	atlasEntries.clear();
 
 	return true;
 }
@@ -45,6 +62,7 @@ bool Textures::CleanUp()
 // Load new texture from file path
 SDL_Texture* const Textures::Load(const char* path)
 {
+	MemScope scope(MemTag::TEXTURES);
 	SDL_Texture* texture = NULL;
 	SDL_Surface* surface = IMG_Load(path);
 
@@ -64,9 +82,12 @@ SDL_Texture* const Textures::Load(const char* path)
 // Unload texture
 bool Textures::UnLoad(SDL_Texture* texture)
 {
-	for (const auto& _texture : textures) {
-		if (_texture == texture) {
+	for (auto it = textures.begin(); it != textures.end(); ++it) {
+		if (*it == texture) {
+			MemoryTracker::Add(MemTag::TEXTURES, -TextureBytes(texture), -1);
 			SDL_DestroyTexture(texture);
+			// Out of the list too, CleanUp would destroy it again
+			textures.erase(it);
 			return true;
 		}
 	}
@@ -85,6 +106,7 @@ SDL_Texture* const Textures::LoadSurface(SDL_Surface* surface)
 	else
 	{
 		textures.push_back(texture);
+		MemoryTracker::Add(MemTag::TEXTURES, TextureBytes(texture), 1);
 	}
 
 	return texture;
@@ -107,3 +129,160 @@ void Textures::GetSize(const SDL_Texture* texture, int& width, int& height) cons
 		height = (int)th;
 	}
 }
+
+TextureRegion Textures::LoadRegion(const char* path, AtlasGroup group)
+{
+	for (const AtlasEntry& entry : atlasEntries)
+	{
+		if (entry.group == group && entry.path == path)
+			return entry.region;
+	}
+
+	MemScope scope(MemTag::TEXTURES);
+	TextureRegion region;
+	SDL_Surface* loaded = IMG_Load(path);
+	if (loaded == NULL)
+	{
+		LOG("Could not load surface with path: %s. IMG_Load: %s", path, SDL_GetError());
+		return region;
+	}
+
+	// Pages are RGBA32: convert once so the upload is a plain copy
+	SDL_Surface* surface = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+	SDL_DestroySurface(loaded);
+	if (surface == NULL)
+	{
+		LOG("Could not convert %s for the atlas: %s", path, SDL_GetError());
+		return region;
+	}
+
+	if (AddToAtlas(surface, group, region))
+		atlasEntries.push_back({ path, group, region });
+	else
+		LOG("Could not add %s to an atlas page", path);
+
+	SDL_DestroySurface(surface);
+	return region;
+}
+
+bool Textures::AddToAtlas(SDL_Surface* surface, AtlasGroup group, TextureRegion& region)
+{
+	int w = surface->w + atlasPadding * 2;
+	int h = surface->h + atlasPadding * 2;
+	int size = GetAtlasSize(group);
+
+	SDL_Rect slot;
+	AtlasPage* page = nullptr;
+	for (AtlasPage& candidate : atlasPages)
+	{
+		if (candidate.group == group && candidate.packer.Insert(w, h, slot))
+		{
+			page = &candidate;
+			break;
+		}
+	}
+
+	if (page == nullptr)
+	{
+		// Too big for a shared page: a page of its own size
+		if (w > size || h > size)
+			page = CreateAtlasPage(group, w, h);
+		else
+			page = CreateAtlasPage(group, size, size);
+
+		if (page == nullptr || !page->packer.Insert(w, h, slot))
+			return false;
+	}
+
+	// The padding goes up with the image so the border is transparent, not whatever the page had
+	SDL_Surface* padded = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_RGBA32);
+	if (padded == NULL)
+		return false;
+	SDL_ClearSurface(padded, 0.0f, 0.0f, 0.0f, 0.0f);
+	SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+	SDL_Rect dst = { atlasPadding, atlasPadding, surface->w, surface->h };
+	SDL_BlitSurface(surface, NULL, padded, &dst);
+
+	bool ret = SDL_UpdateTexture(page->texture, &slot, padded->pixels, padded->pitch);
+	SDL_DestroySurface(padded);
+	if (!ret)
+	{
+		LOG("SDL_UpdateTexture failed: %s", SDL_GetError());
+		return false;
+	}
+
+	region.texture = page->texture;
+	region.rect = { slot.x + atlasPadding, slot.y + atlasPadding, surface->w, surface->h };
+	return true;
+}
+
+Textures::AtlasPage* Textures::CreateAtlasPage(AtlasGroup group, int width, int height)
+{
+	SDL_Texture* texture = SDL_CreateTexture(Engine::GetInstance().render->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+	if (texture == NULL)
+	{
+		LOG("Unable to create a %dx%d atlas page! SDL Error: %s", width, height, SDL_GetError());
+		return nullptr;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	textures.push_back(texture);
+	MemoryTracker::Add(MemTag::TEXTURES, TextureBytes(texture), 1);
+
+	AtlasPage page;
+	page.texture = texture;
+	page.group = group;
+	page.packer.Init(width, height);
+	atlasPages.push_back(page);
+	return &atlasPages.back();
+}
+
+// Page size of the group, within what the renderer supports
+int Textures::GetAtlasSize(AtlasGroup group) const
+{
+	int size = group == AtlasGroup::LEVEL ? atlasLevelSize : atlasCommonSize;
+	SDL_PropertiesID props = SDL_GetRendererProperties(Engine::GetInstance().render->renderer);
+	int maxSize = (int)SDL_GetNumberProperty(props, SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, size);
+	return SDL_min(size, maxSize);
+}
+
+void Textures::ReleaseAtlas(AtlasGroup group)
+{
+	for (auto it = atlasPages.begin(); it != atlasPages.end();)
+	{
+		if (it->group == group)
+		{
+			UnLoad(it->texture);
+			it = atlasPages.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	for (auto it = atlasEntries.begin(); it != atlasEntries.end();)
+	{
+		if (it->group == group)
+			it = atlasEntries.erase(it);
+		else
+			++it;
+	}
+}
+
+int Textures::GetAtlasPageCount(AtlasGroup group, float& occupancy) const
+{
+	int count = 0;
+	occupancy = 0.0f;
+	for (const AtlasPage& page : atlasPages)
+	{
+		if (page.group == group)
+		{
+			occupancy += page.packer.GetOccupancy();
+			++count;
+		}
+	}
+	if (count > 0)
+		occupancy /= count;
+	return count;
+}
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "Module.h"
+#include "TextureAtlas.h"
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
+#include <string>
+#include <vector>
+
+#define ATLAS_LEVEL_SIZE 2048
+#define ATLAS_COMMON_SIZE 512
+#define ATLAS_PADDING 1   // transparent border around each image, so filtering never samples a neighbour
 
 class Textures : public Module
 {
@@ -28,7 +35,42 @@ public:
 	bool UnLoad(SDL_Texture* texture);
 	void GetSize(const SDL_Texture* texture, int& width, int& height) const;
 
+	// Loads an image into an atlas page of the group (once per path, later calls return the same region).
+	// Images bigger than a page get a page of their own
+	TextureRegion LoadRegion(const char* path, AtlasGroup group);
+	void ReleaseAtlas(AtlasGroup group);
+
+	// Pages of the group and their mean occupancy
+	int GetAtlasPageCount(AtlasGroup group, float& occupancy) const;
+
+private:
+
+	struct AtlasPage
+	{
+		SDL_Texture* texture;
+		AtlasGroup group;
+		SkylinePacker packer;
+	};
+
+	struct AtlasEntry
+	{
+		std::string path;
+		AtlasGroup group;
+		TextureRegion region;
+	};
+
+	bool AddToAtlas(SDL_Surface* surface, AtlasGroup group, TextureRegion& region);
+	AtlasPage* CreateAtlasPage(AtlasGroup group, int width, int height);
+	int GetAtlasSize(AtlasGroup group) const;
+
 public:
 	std::list<SDL_Texture*> textures;
 
+private:
+	std::vector<AtlasPage> atlasPages;
+	std::vector<AtlasEntry> atlasEntries;
+	int atlasLevelSize = ATLAS_LEVEL_SIZE;
+	int atlasCommonSize = ATLAS_COMMON_SIZE;
+	int atlasPadding = ATLAS_PADDING;
+
 };
@@ -0,0 +1,178 @@
+#include "Triggers.h"
+#include "Engine.h"
+#include "Render.h"
+#include "Entity.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <math.h>
+
+#define MAX_TRIGGER_OVERLAPS 32
+
+TriggerSystem::TriggerSystem()
+{
+}
+
+int TriggerSystem::AddTrigger(TriggerType type, const SDL_FRect& bounds, const std::string& name, Entity* listener)
+{
+	Trigger trigger;
+	trigger.id = (int)triggers.size();
+	trigger.type = type;
+	trigger.name = name;
+	trigger.bounds = bounds;
+	trigger.listener = listener;
+	triggers.push_back(trigger);
+	queryStamps.push_back(0);
+
+	// Insert the id in every cell the AABB touches
+	int minX = (int)floorf(bounds.x / TRIGGER_CELL_SIZE);
+	int minY = (int)floorf(bounds.y / TRIGGER_CELL_SIZE);
+	int maxX = (int)floorf((bounds.x + bounds.w) / TRIGGER_CELL_SIZE);
+	int maxY = (int)floorf((bounds.y + bounds.h) / TRIGGER_CELL_SIZE);
+
+	for (int cy = minY; cy <= maxY; ++cy) {
+		for (int cx = minX; cx <= maxX; ++cx) {
+			cells[CellKey(cx, cy)].push_back(trigger.id);
+		}
+	}
+
+	return trigger.id;
+}
+
+void TriggerSystem::RemoveTrigger(int id)
+{
+	Trigger* trigger = GetTrigger(id);
+	if (trigger != nullptr) {
+		trigger->enabled = false;
+	}
+}
+
+Trigger* TriggerSystem::GetTrigger(int id)
+{
+	if (id < 0 || id >= (int)triggers.size()) return nullptr;
+	return &triggers[id];
+}
+
+void TriggerSystem::Clear()
+{
+	triggers.clear();
+	cells.clear();
+	inside.clear();
+	queryStamps.clear();
+	queryStamp = 0;
+}
+
+int TriggerSystem::Query(const SDL_FRect& aabb, int* out, int capacity) const
+{
+	// New stamp for this query, restart the stamps if the counter wraps
+	if (++queryStamp == 0) {
+		std::fill(queryStamps.begin(), queryStamps.end(), 0);
+		queryStamp = 1;
+	}
+
+	int count = 0;
+	int minX = (int)floorf(aabb.x / TRIGGER_CELL_SIZE);
+	int minY = (int)floorf(aabb.y / TRIGGER_CELL_SIZE);
+	int maxX = (int)floorf((aabb.x + aabb.w) / TRIGGER_CELL_SIZE);
+	int maxY = (int)floorf((aabb.y + aabb.h) / TRIGGER_CELL_SIZE);
+
+	for (int cy = minY; cy <= maxY; ++cy) {
+		for (int cx = minX; cx <= maxX; ++cx) {
+			auto cell = cells.find(CellKey(cx, cy));
+			if (cell == cells.end()) continue;
+
+			for (int id : cell->second) {
+				if (queryStamps[id] == queryStamp) continue;
+				queryStamps[id] = queryStamp;
+
+				const Trigger& trigger = triggers[id];
+				if (!trigger.enabled || !Overlaps(trigger.bounds, aabb)) continue;
+
+				if (count < capacity) {
+					out[count++] = id;
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+void TriggerSystem::Update(Entity* visitor, const SDL_FRect& aabb)
+{
+	if (visitor == nullptr) return;
+
+	int found[MAX_TRIGGER_OVERLAPS];
+	int count = Query(aabb, found, MAX_TRIGGER_OVERLAPS);
+	std::sort(found, found + count);
+
+	// Diff against the previous overlaps (both lists are sorted)
+	int entered[MAX_TRIGGER_OVERLAPS];
+	int exited[MAX_TRIGGER_OVERLAPS];
+	int enterCount = 0;
+	int exitCount = 0;
+
+	std::vector<int>& previous = inside[visitor];
+	size_t i = 0;
+	size_t j = 0;
+	while (i < previous.size() || j < (size_t)count) {
+		if (j == (size_t)count || (i < previous.size() && previous[i] < found[j])) {
+			if (exitCount < MAX_TRIGGER_OVERLAPS) exited[exitCount++] = previous[i];
+			++i;
+		}
+		else if (i == previous.size() || found[j] < previous[i]) {
+			if (enterCount < MAX_TRIGGER_OVERLAPS) entered[enterCount++] = found[j];
+			++j;
+		}
+		else {
+			++i;
+			++j;
+		}
+	}
+	previous.assign(found, found + count);
+
+	// Dispatch after the state is stored: a listener may clear the system (level change)
+	for (int k = 0; k < exitCount; ++k) {
+		Trigger* trigger = GetTrigger(exited[k]);
+		if (trigger != nullptr) visitor->OnTriggerExit(trigger);
+	}
+	for (int k = 0; k < enterCount; ++k) {
+		Trigger* trigger = GetTrigger(entered[k]);
+		if (trigger != nullptr && trigger->enabled) visitor->OnTriggerEnter(trigger);
+	}
+}
+
+void TriggerSystem::DebugDraw() const
+{
+	for (const auto& trigger : triggers) {
+		if (!trigger.enabled) continue;
+
+		SDL_Rect rect = { (int)trigger.bounds.x, (int)trigger.bounds.y, (int)trigger.bounds.w, (int)trigger.bounds.h };
+		switch (trigger.type)
+		{
+		case TriggerType::COIN:
+			Engine::GetInstance().render->DrawRectangle(rect, 255, 215, 0, 255, false);
+			break;
+		case TriggerType::CHECKPOINT:
+			Engine::GetInstance().render->DrawRectangle(rect, 0, 255, 255, 255, false);
+			break;
+		case TriggerType::LEVEL_EXIT:
+			Engine::GetInstance().render->DrawRectangle(rect, 255, 0, 255, 255, false);
+			break;
+		default:
+			Engine::GetInstance().render->DrawRectangle(rect, 0, 255, 0, 255, false);
+			break;
+		}
+	}
+}
+
+long long TriggerSystem::CellKey(int cx, int cy)
+{
+	return (long long)(((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy);
+}
+
+bool TriggerSystem::Overlaps(const SDL_FRect& a, const SDL_FRect& b)
+{
+	return a.x < b.x + b.w && b.x < a.x + a.w &&
+		a.y < b.y + b.h && b.y < a.y + a.h;
+}
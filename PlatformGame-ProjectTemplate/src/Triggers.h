@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <SDL3/SDL_rect.h>
+
+class Entity;
+struct Checkpoint;
+
+#define TRIGGER_CELL_SIZE 128.0f
+
+enum class TriggerType
+{
+	COIN,
+	CHECKPOINT,
+	SPAWN_ZONE,
+	LEVEL_EXIT,
+	UNKNOWN
+};
+
+// Axis aligned volume that only produces enter / exit events (no Box2D body)
+struct Trigger
+{
+	int id = -1;
+	TriggerType type = TriggerType::UNKNOWN;
+	std::string name;
+	SDL_FRect bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+	bool enabled = true;
+
+	// Optional payloads
+	Entity* listener = nullptr;       // owner of the trigger (e.g. the coin Item)
+	Checkpoint* checkpoint = nullptr; // set for CHECKPOINT triggers
+};
+
+// Static spatial hash of trigger AABBs, queried once per tick by the visitors
+class TriggerSystem
+{
+public:
+
+	TriggerSystem();
+
+	// Returns the trigger id
+	int AddTrigger(TriggerType type, const SDL_FRect& bounds, const std::string& name, Entity* listener = nullptr);
+
+	// Disables the trigger, its cell entries are dropped on the next Clear()
+	void RemoveTrigger(int id);
+
+	Trigger* GetTrigger(int id);
+
+	// Remove every trigger (level unload)
+	void Clear();
+
+	// Overlap the visitor AABB and call OnTriggerEnter / OnTriggerExit on the visitor
+	void Update(Entity* visitor, const SDL_FRect& aabb);
+
+	// Fill 'out' with the ids of the enabled triggers overlapping the AABB, returns the count
+	int Query(const SDL_FRect& aabb, int* out, int capacity) const;
+
+	int GetCount() const { return (int)triggers.size(); }
+
+	// Draw the trigger volumes (physics debug view)
+	void DebugDraw() const;
+
+private:
+
+	static long long CellKey(int cx, int cy);
+	static bool Overlaps(const SDL_FRect& a, const SDL_FRect& b);
+
+	std::vector<Trigger> triggers;
+	std::unordered_map<long long, std::vector<int>> cells;
+
+	// Triggers each visitor was inside of during the last Update
+	std::unordered_map<Entity*, std::vector<int>> inside;
+
+	// Query de-duplication (a trigger can span several cells)
+	mutable std::vector<unsigned int> queryStamps;
+	mutable unsigned int queryStamp = 0;
+};
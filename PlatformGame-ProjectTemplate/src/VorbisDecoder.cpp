@@ -0,0 +1,81 @@
+#include "MusicStream.h"
+#include "Log.h"
+
+#include <stdlib.h>
+
+// stb_vorbis implementation (vcpkg "stb" port), compiled only in this file
+#include <stb_vorbis.c>
+
+// stb_vorbis leaks a few one-letter macros
+#undef L
+#undef C
+#undef R
+
+VorbisDecoder::~VorbisDecoder() {
+    Close();
+}
+
+bool VorbisDecoder::Open(const char* path) {
+    Close();
+
+    int error = 0;
+    vorbis_ = stb_vorbis_open_filename(path, &error, nullptr);
+    if (!vorbis_) {
+        LOG("Music: cannot open Ogg Vorbis %s (stb_vorbis error %d)", path, error);
+        return false;
+    }
+
+    stb_vorbis_info info = stb_vorbis_get_info(vorbis_);
+    if (info.channels <= 0 || info.channels > MUSIC_MAX_CHANNELS) {
+        LOG("Music: unsupported channel count %d in %s", info.channels, path);
+        Close();
+        return false;
+    }
+
+    spec.format = SDL_AUDIO_F32;
+    spec.channels = info.channels;
+    spec.freq = (int)info.sample_rate;
+    totalFrames = (int)stb_vorbis_stream_length_in_samples(vorbis_);
+
+    // Loop tags used by most game audio tools: LOOPSTART=<frame> LOOPLENGTH=<frames>
+    int loopLength = 0;
+    stb_vorbis_comment comments = stb_vorbis_get_comment(vorbis_);
+    for (int i = 0; i < comments.comment_list_length; ++i) {
+        const char* c = comments.comment_list[i];
+        if (SDL_strncasecmp(c, "LOOPSTART=", 10) == 0) loopStart = atoi(c + 10);
+        else if (SDL_strncasecmp(c, "LOOPLENGTH=", 11) == 0) loopLength = atoi(c + 11);
+    }
+    loopEnd = loopLength > 0 ? loopStart + loopLength : 0;
+    if (loopStart < 0 || loopStart >= totalFrames || loopEnd > totalFrames) {
+        loopStart = 0;
+        loopEnd = 0;
+    }
+
+    position = 0;
+    return true;
+}
+
+void VorbisDecoder::Close() {
+    if (vorbis_) {
+        stb_vorbis_close(vorbis_);
+        vorbis_ = nullptr;
+    }
+}
+
+int VorbisDecoder::Read(float* out, int frames) {
+    if (!vorbis_) return 0;
+    if (frames > MUSIC_CHUNK_FRAMES) frames = MUSIC_CHUNK_FRAMES;
+
+    // Decodes only the packets needed for these frames
+    int got = stb_vorbis_get_samples_float_interleaved(vorbis_, spec.channels, out, frames * spec.channels);
+    position += got;
+    return got;
+}
+
+bool VorbisDecoder::Seek(int frame) {
+    if (!vorbis_) return false;
+    if (frame < 0) frame = 0;
+    if (!stb_vorbis_seek(vorbis_, (unsigned int)frame)) return false;
+    position = frame;
+    return true;
+}
@@ -0,0 +1,280 @@
+// MapGenerator: writes procedural TMX maps for scaling tests, loadable by Map::Load.
+// The maps use the tilesets of MapTemplate.tmx, write them next to it (Assets/Maps/) so the images resolve.
+//
+//   MapGenerator --out Assets/Maps/Stress_1024.tmx [--width 1024] [--height 256] [--layers 2]
+//                [--density 0.05] [--coins 200] [--checkpoints 8] [--seed 1]
+//
+// Layer data is CSV encoded: a 4096x4096 layer is ~35 MB instead of ~300 MB of <tile> nodes.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define MAX_MAP_SIZE 4096
+#define TILE_SIZE 32
+
+// Gids of the MapTemplate.tmx tilesets
+#define GID_SOLID 1          // MapMetadata: solid collider
+#define GID_DAMAGE 2         // MapMetadata: damage collider
+#define GID_PLATFORM 3       // Platforms: first tile
+#define GID_DECORATIVE 903   // Decorative: first tile
+#define DECORATIVE_COUNT 400
+#define GID_COIN 1303
+#define GID_ONEWAY 1304      // MapData: one-way collider
+
+#define GROUND_ROWS 2
+
+// xorshift32: same map for the same seed on every platform
+struct Random
+{
+	uint32_t state;
+
+	uint32_t Next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	int Range(int min, int max)
+	{
+		return min + (int)(Next() % (uint32_t)(max - min + 1));
+	}
+
+	float Unit()
+	{
+		return (Next() & 0xFFFFFF) / (float)0x1000000;
+	}
+};
+
+struct Settings
+{
+	const char* outPath = nullptr;
+	int width = 1024;
+	int height = 256;
+	int layers = 2;          // drawn layers, the first one follows the colliders
+	float density = 0.05f;   // fraction of the tiles above the ground that are platforms
+	int coins = 200;
+	int checkpoints = 8;
+	uint32_t seed = 1;
+};
+
+struct Coin
+{
+	float x;
+	float y;
+};
+
+struct GeneratedMap
+{
+	std::vector<uint16_t> collisions;
+	std::vector<uint16_t> damage;
+	std::vector<std::vector<uint16_t>> drawLayers;
+	std::vector<Coin> coins;
+	std::vector<int> platformTops;   // tile index of each platform start, for coins
+};
+
+static void Generate(const Settings& s, GeneratedMap& map)
+{
+	const size_t count = (size_t)s.width * s.height;
+	Random random{ s.seed ? s.seed : 1 };
+
+	map.collisions.assign(count, 0);
+	map.damage.assign(count, 0);
+	map.drawLayers.assign(s.layers, std::vector<uint16_t>(count, 0));
+
+	// Ground along the bottom
+	for (int y = s.height - GROUND_ROWS; y < s.height; ++y)
+	{
+		for (int x = 0; x < s.width; ++x)
+			map.collisions[(size_t)y * s.width + x] = GID_SOLID;
+	}
+
+	// Platforms: runs of 3 to 8 tiles, half solid and half one-way, until the density is reached
+	const int playableRows = s.height - GROUND_ROWS - 4;
+	const size_t target = (size_t)(s.density * (double)s.width * (playableRows > 0 ? playableRows : 0));
+	size_t placed = 0;
+	while (playableRows > 0 && placed < target)
+	{
+		int length = random.Range(3, 8);
+		int x = random.Range(0, s.width - length);
+		int y = random.Range(3, s.height - GROUND_ROWS - 2);
+		uint16_t gid = (random.Next() & 1) ? GID_SOLID : GID_ONEWAY;
+
+		for (int i = 0; i < length; ++i)
+			map.collisions[(size_t)y * s.width + x + i] = gid;
+
+		map.platformTops.push_back(y * s.width + x + length / 2);
+		placed += length;
+	}
+
+	// Damage tiles on the ground, one every ~32 tiles
+	const int groundTop = s.height - GROUND_ROWS;
+	for (int x = 8; x < s.width; x += random.Range(16, 48))
+		map.damage[(size_t)groundTop * s.width + x] = GID_DAMAGE;
+
+	// First drawn layer shows the colliders, the others are scattered decoration
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (map.collisions[i] != 0)
+			map.drawLayers[0][i] = GID_PLATFORM;
+	}
+	for (int l = 1; l < s.layers; ++l)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (map.collisions[i] == 0 && random.Unit() < 0.05f)
+				map.drawLayers[l][i] = (uint16_t)(GID_DECORATIVE + random.Range(0, DECORATIVE_COUNT - 1));
+		}
+	}
+
+	// Coins above platforms, or above the ground when there are none
+	for (int c = 0; c < s.coins; ++c)
+	{
+		int tx, ty;
+		if (!map.platformTops.empty())
+		{
+			int top = map.platformTops[random.Next() % map.platformTops.size()];
+			tx = top % s.width;
+			ty = top / s.width;
+		}
+		else
+		{
+			tx = random.Range(0, s.width - 1);
+			ty = groundTop;
+		}
+		map.coins.push_back({ (float)(tx * TILE_SIZE), (float)(ty * TILE_SIZE) });
+	}
+}
+
+// Appends "gid," rows without going through printf: huge maps have tens of millions of tiles
+static void WriteCsv(FILE* out, const std::vector<uint16_t>& tiles, int width, int height)
+{
+	std::string row;
+	row.reserve((size_t)width * 6);
+	char digits[8];
+	for (int y = 0; y < height; ++y)
+	{
+		row.clear();
+		for (int x = 0; x < width; ++x)
+		{
+			unsigned int gid = tiles[(size_t)y * width + x];
+			int n = 0;
+			do { digits[n++] = (char)('0' + gid % 10); gid /= 10; } while (gid != 0);
+			while (n > 0) row.push_back(digits[--n]);
+			if (x + 1 < width || y + 1 < height) row.push_back(',');
+		}
+		row.push_back('\n');
+		fwrite(row.data(), 1, row.size(), out);
+	}
+}
+
+static void WriteLayer(FILE* out, int id, const char* name, bool draw, const std::vector<uint16_t>& tiles, const Settings& s)
+{
+	fprintf(out, " <layer id=\"%d\" name=\"%s\" width=\"%d\" height=\"%d\">\n", id, name, s.width, s.height);
+	fprintf(out, "  <properties>\n   <property name=\"Draw\" type=\"bool\" value=\"%s\"/>\n  </properties>\n", draw ? "true" : "false");
+	fprintf(out, "  <data encoding=\"csv\">\n");
+	WriteCsv(out, tiles, s.width, s.height);
+	fprintf(out, "</data>\n </layer>\n");
+}
+
+static bool Write(const Settings& s, const GeneratedMap& map)
+{
+	FILE* out = fopen(s.outPath, "wb");
+	if (out == nullptr)
+	{
+		fprintf(stderr, "MapGenerator: cannot create %s\n", s.outPath);
+		return false;
+	}
+
+	fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(out, "<map version=\"1.10\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"%d\" height=\"%d\" tilewidth=\"%d\" tileheight=\"%d\" infinite=\"0\">\n",
+		s.width, s.height, TILE_SIZE, TILE_SIZE);
+
+	// Same tilesets as MapTemplate.tmx
+	fprintf(out, " <tileset firstgid=\"1\" name=\"MapMetadata\" tilewidth=\"32\" tileheight=\"32\" spacing=\"1\" margin=\"1\" tilecount=\"2\" columns=\"2\">\n  <image source=\"MapMetadata.png\" width=\"67\" height=\"34\"/>\n </tileset>\n");
+	fprintf(out, " <tileset firstgid=\"3\" name=\"Platforms\" tilewidth=\"32\" tileheight=\"32\" tilecount=\"900\" columns=\"30\">\n  <image source=\"platforms.png\" width=\"960\" height=\"960\"/>\n </tileset>\n");
+	fprintf(out, " <tileset firstgid=\"903\" name=\"Decorative\" tilewidth=\"32\" tileheight=\"32\" tilecount=\"400\" columns=\"20\">\n  <image source=\"decorative.png\" width=\"640\" height=\"640\"/>\n </tileset>\n");
+	fprintf(out, " <tileset firstgid=\"1303\" name=\"Coins\" tilewidth=\"32\" tileheight=\"32\" tilecount=\"1\" columns=\"1\">\n  <image source=\"../Textures/goldCoin.png\" width=\"32\" height=\"32\"/>\n </tileset>\n");
+	fprintf(out, " <tileset firstgid=\"1304\" name=\"MapData\" tilewidth=\"32\" tileheight=\"32\" spacing=\"1\" margin=\"1\" tilecount=\"1\" columns=\"1\">\n  <image source=\"MapData2.png\" width=\"34\" height=\"34\"/>\n </tileset>\n");
+	fprintf(out, " <imagelayer id=\"1\" name=\"background\" repeatx=\"1\" repeaty=\"1\">\n  <image source=\"background1.png\" width=\"1376\" height=\"768\"/>\n </imagelayer>\n");
+
+	int id = 2;
+	for (int l = 0; l < s.layers; ++l)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), l == 0 ? "Map" : "Decoration%d", l);
+		WriteLayer(out, id++, name, true, map.drawLayers[l], s);
+	}
+	WriteLayer(out, id++, "Damage", false, map.damage, s);
+	WriteLayer(out, id++, "Collisions", false, map.collisions, s);
+
+	int objectId = 1;
+	fprintf(out, " <objectgroup id=\"%d\" name=\"Coins\">\n", id++);
+	for (size_t c = 0; c < map.coins.size(); ++c)
+	{
+		fprintf(out, "  <object id=\"%d\" name=\"Coin%d\" gid=\"%d\" x=\"%.0f\" y=\"%.0f\" width=\"32\" height=\"32\"/>\n",
+			objectId++, (int)c + 1, GID_COIN, map.coins[c].x, map.coins[c].y);
+	}
+	fprintf(out, " </objectgroup>\n");
+
+	// Spawn on the left above the ground, checkpoints spread along the map
+	const float groundY = (float)((s.height - GROUND_ROWS) * TILE_SIZE) - 16.0f;
+	fprintf(out, " <objectgroup id=\"%d\" name=\"SpawnPoint\">\n", id++);
+	fprintf(out, "  <object id=\"%d\" name=\"PlayerSpawn\" x=\"80\" y=\"%.0f\">\n   <point/>\n  </object>\n", objectId++, groundY);
+	for (int c = 0; c < s.checkpoints; ++c)
+	{
+		float x = (float)(c + 1) * s.width * TILE_SIZE / (s.checkpoints + 1);
+		fprintf(out, "  <object id=\"%d\" name=\"Checkpoint%d\" x=\"%.0f\" y=\"%.0f\">\n   <point/>\n  </object>\n", objectId++, c + 1, x, groundY);
+	}
+	fprintf(out, " </objectgroup>\n");
+
+	fprintf(out, "</map>\n");
+	bool ok = ferror(out) == 0;
+	fclose(out);
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	Settings s;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const char* value = argv[++i];
+		if (strcmp(arg, "--out") == 0) s.outPath = value;
+		else if (strcmp(arg, "--width") == 0) s.width = atoi(value);
+		else if (strcmp(arg, "--height") == 0) s.height = atoi(value);
+		else if (strcmp(arg, "--layers") == 0) s.layers = atoi(value);
+		else if (strcmp(arg, "--density") == 0) s.density = (float)atof(value);
+		else if (strcmp(arg, "--coins") == 0) s.coins = atoi(value);
+		else if (strcmp(arg, "--checkpoints") == 0) s.checkpoints = atoi(value);
+		else if (strcmp(arg, "--seed") == 0) s.seed = (uint32_t)strtoul(value, nullptr, 10);
+		else
+		{
+			fprintf(stderr, "MapGenerator: unknown option %s\n", arg);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (s.outPath == nullptr || s.width < 16 || s.height < 16 || s.width > MAX_MAP_SIZE || s.height > MAX_MAP_SIZE ||
+		s.layers < 1 || s.density < 0.0f || s.density > 1.0f || s.coins < 0 || s.checkpoints < 0)
+	{
+		fprintf(stderr, "usage: MapGenerator --out <map.tmx> [--width 16..%d] [--height 16..%d] [--layers >=1]\n"
+			"                    [--density 0..1] [--coins n] [--checkpoints n] [--seed n]\n", MAX_MAP_SIZE, MAX_MAP_SIZE);
+		return EXIT_FAILURE;
+	}
+
+	GeneratedMap map;
+	Generate(s, map);
+	if (!Write(s, map))
+		return EXIT_FAILURE;
+
+	printf("MapGenerator: %s %dx%d, %d drawn layers, %zu platforms, %d coins, %d checkpoints\n",
+		s.outPath, s.width, s.height, s.layers, map.platformTops.size(), s.coins, s.checkpoints);
+	return EXIT_SUCCESS;
+}